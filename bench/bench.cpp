@@ -0,0 +1,435 @@
+//Headless benchmark of the render path. Meant to run on a software Vulkan driver (see "make bench"),
+//so the numbers only depend on the CPU and stay comparable between machines of the same kind.
+#include "bench.h"
+#include "../renderer.h"
+#include "../vulkanHelper.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//Fixed amounts so two runs always measure the same work
+const uint32_t startupIterations = 5;
+const uint32_t resizeIterations = 30;
+const uint32_t warmupFrames = 10;
+const uint32_t frameIterations = 200;
+const uint32_t pipelineIterations = 20;
+const uint32_t drawCounts[] = {100, 1000, 10000};
+const uint32_t occlusionCullingDrawCount = 1000;
+const uint32_t lodFrameIterations = 50;
+const uint32_t lodSphereRings = 100;
+const uint32_t lodSphereSegments = 120;
+const char *lodMeshFilename = "bench_lod_sphere.obj";
+const VkExtent2D resizeExtents[] = {{400, 300}, {800, 600}, {1280, 720}, {640, 480}};
+
+struct BenchResult
+{
+    std::string name;
+    std::vector<double> samples; //Milliseconds
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+std::vector<BenchResult> results;
+
+double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+//Nearest rank percentile of sorted samples
+double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+    rank = std::min(std::max(rank, (size_t)1), sorted.size());
+    return sorted[rank - 1];
+}
+
+double median(const std::vector<double> &sorted)
+{
+    size_t middle = sorted.size() / 2;
+    if (sorted.size() % 2 == 0)
+        return (sorted[middle - 1] + sorted[middle]) / 2.0;
+    return sorted[middle];
+}
+
+void addResult(const std::string &name, const std::vector<double> &samples)
+{
+    results.push_back({name, samples});
+    std::sort(results.back().samples.begin(), results.back().samples.end());
+}
+
+void addMetric(const std::string &key, double value)
+{
+    results.back().metrics.push_back({key, value});
+}
+
+double getLastMedian()
+{
+    return median(results.back().samples);
+}
+
+void benchStartup()
+{
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < startupIterations; i++)
+    {
+        width = resizeExtents[0].width;
+        height = resizeExtents[0].height;
+
+        auto start = Clock::now();
+        startVulkan();
+        drawFrame();
+        vkQueueWaitIdle(queue);
+        samples.push_back(millisecondsSince(start));
+
+        shutdownVulkan();
+    }
+    addResult("startup_to_first_frame", samples);
+}
+
+//Everything a window resize causes, up to the first finished frame in the new size
+void benchResize()
+{
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < resizeIterations; i++)
+    {
+        const VkExtent2D &extent = resizeExtents[(i + 1) % (sizeof(resizeExtents) / sizeof(resizeExtents[0]))];
+        width = extent.width;
+        height = extent.height;
+
+        auto start = Clock::now();
+        recreateSwapchain();
+        drawFrame();
+        vkQueueWaitIdle(queue);
+        samples.push_back(millisecondsSince(start));
+    }
+    addResult("resize_to_frame", samples);
+}
+
+void benchFrames(uint32_t drawCount)
+{
+    sceneDrawCount = drawCount;
+    for (uint32_t i = 0; i < warmupFrames; i++)
+    {
+        drawFrame();
+    }
+
+    std::vector<double> recordSamples;
+    std::vector<double> submitSamples;
+    for (uint32_t i = 0; i < frameIterations; i++)
+    {
+        drawFrame();
+        recordSamples.push_back(lastFrameTimings.recordMs);
+        submitSamples.push_back(lastFrameTimings.submitMs);
+    }
+    vkQueueWaitIdle(queue);
+
+    addResult("record_" + std::to_string(drawCount) + "_draws", recordSamples);
+    addMetric("triangles", lastFrameTimings.triangleCount);
+    addResult("submit_" + std::to_string(drawCount) + "_draws", submitSamples);
+}
+
+//Whole frames including the GPU work, with and without occlusion culling. Culling is a startup setting, so each
+//variant gets its own device
+void benchOcclusionCulling()
+{
+    sceneDrawCount = occlusionCullingDrawCount;
+    for (bool culling : {false, true})
+    {
+        useOcclusionCulling = culling;
+        width = resizeExtents[0].width;
+        height = resizeExtents[0].height;
+        startVulkan();
+        for (uint32_t i = 0; i < warmupFrames; i++)
+        {
+            drawFrame();
+        }
+
+        std::vector<double> samples;
+        for (uint32_t i = 0; i < frameIterations; i++)
+        {
+            auto start = Clock::now();
+            drawFrame();
+            vkQueueWaitIdle(queue);
+            samples.push_back(millisecondsSince(start));
+        }
+
+        std::string name = "gpu_frame_" + std::to_string(occlusionCullingDrawCount) + "_draws";
+        addResult(culling ? name + "_occlusion_culling" : name, samples);
+        if (culling)
+            addMetric("culled_draws", lastFrameTimings.culledDraws);
+        shutdownVulkan();
+    }
+    useOcclusionCulling = false;
+}
+
+//Dense sphere with a uv seam and poles, as the mesh every draw of the level of detail scenario uses
+void writeSphereObj(const char *filename)
+{
+    std::ofstream file(filename);
+    for (uint32_t ring = 0; ring <= lodSphereRings; ring++)
+    {
+        for (uint32_t segment = 0; segment <= lodSphereSegments; segment++)
+        {
+            float theta = M_PI * ring / lodSphereRings;
+            float phi = 2.0 * M_PI * segment / lodSphereSegments;
+            file << "v " << sinf(theta) * cosf(phi) << ' ' << cosf(theta) << ' ' << sinf(theta) * sinf(phi) << '\n';
+            file << "vt " << float(segment) / lodSphereSegments << ' ' << float(ring) / lodSphereRings << '\n';
+        }
+    }
+    for (uint32_t ring = 0; ring < lodSphereRings; ring++)
+    {
+        for (uint32_t segment = 0; segment < lodSphereSegments; segment++)
+        {
+            uint32_t a = ring * (lodSphereSegments + 1) + segment + 1;
+            uint32_t b = a + lodSphereSegments + 1;
+            file << "f " << a << '/' << a << ' ' << b << '/' << b << ' ' << b + 1 << '/' << b + 1 << '\n';
+            file << "f " << a << '/' << a << ' ' << b + 1 << '/' << b + 1 << ' ' << a + 1 << '/' << a + 1 << '\n';
+        }
+    }
+}
+
+//Whole frames of the default scene drawing the dense sphere, always the full mesh and with levels of detail
+//picked for an error of one pixel. Every draw has the same scale, so all of them pick the same level
+void benchLodFrames()
+{
+    writeSphereObj(lodMeshFilename);
+    meshFilename = lodMeshFilename;
+    float defaultPixelError = lodPixelError;
+    for (float pixelError : {0.f, 1.f})
+    {
+        lodPixelError = pixelError;
+        width = resizeExtents[0].width;
+        height = resizeExtents[0].height;
+        startVulkan();
+        for (uint32_t i = 0; i < warmupFrames; i++)
+        {
+            drawFrame();
+        }
+
+        std::vector<double> samples;
+        for (uint32_t i = 0; i < lodFrameIterations; i++)
+        {
+            auto start = Clock::now();
+            drawFrame();
+            vkQueueWaitIdle(queue);
+            samples.push_back(millisecondsSince(start));
+        }
+
+        std::string name = "gpu_frame_" + std::to_string(sceneDrawCount) + "_spheres";
+        addResult(pixelError > 0.f ? name + "_lod" : name, samples);
+        addMetric("triangles", lastFrameTimings.triangleCount);
+        shutdownVulkan();
+    }
+    lodPixelError = defaultPixelError;
+    meshFilename = NULL;
+    std::remove(lodMeshFilename);
+}
+
+VkPipelineCache createEmptyPipelineCache()
+{
+    VkPipelineCacheCreateInfo pipelineCacheCreateInfo;
+    pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipelineCacheCreateInfo.pNext = NULL;
+    pipelineCacheCreateInfo.flags = 0;
+    pipelineCacheCreateInfo.initialDataSize = 0;
+    pipelineCacheCreateInfo.pInitialData = NULL;
+
+    VkPipelineCache cache;
+    VkResult result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, NULL, &cache);
+    ASSERT_VULKAN(result);
+    return cache;
+}
+
+double timePipelineCreation()
+{
+    auto start = Clock::now();
+    VkPipeline pipeline = createGraphicsPipeline(renderPass, false, VK_COMPARE_OP_LESS, VK_TRUE);
+    double milliseconds = millisecondsSince(start);
+    vkDestroyPipeline(device, pipeline, NULL);
+    return milliseconds;
+}
+
+void benchPipelines()
+{
+    VkPipelineCache rendererCache = pipelineCache;
+
+    //Cold: every creation starts with an empty cache
+    std::vector<double> coldSamples;
+    for (uint32_t i = 0; i < pipelineIterations; i++)
+    {
+        pipelineCache = createEmptyPipelineCache();
+        coldSamples.push_back(timePipelineCreation());
+        vkDestroyPipelineCache(device, pipelineCache, NULL);
+    }
+
+    //Warm: the cache already holds the pipeline
+    pipelineCache = createEmptyPipelineCache();
+    timePipelineCreation();
+    std::vector<double> warmSamples;
+    for (uint32_t i = 0; i < pipelineIterations; i++)
+    {
+        warmSamples.push_back(timePipelineCreation());
+    }
+    vkDestroyPipelineCache(device, pipelineCache, NULL);
+
+    pipelineCache = rendererCache;
+    addResult("pipeline_create_cold", coldSamples);
+    addResult("pipeline_create_warm", warmSamples);
+}
+
+//One scenario per line, compare mode relies on that
+void writeJson(std::ostream &out)
+{
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"unit\": \"ms\",\n  \"scenarios\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &result = results[i];
+        out << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.samples.size()
+            << ", \"median\": " << median(result.samples)
+            << ", \"p90\": " << percentile(result.samples, 90)
+            << ", \"p99\": " << percentile(result.samples, 99)
+            << ", \"min\": " << result.samples.front()
+            << ", \"max\": " << result.samples.back();
+        for (auto &&metric : result.metrics)
+        {
+            out << ", \"" << metric.first << "\": " << metric.second;
+        }
+        out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+//Reads name and median of every scenario line written by writeJson
+std::map<std::string, double> readBaseline(const std::string &filename)
+{
+    std::map<std::string, double> medians;
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cout << "Failed to open baseline " << filename << '\n';
+        return medians;
+    }
+
+    const std::string nameTag = "\"name\": \"";
+    const std::string medianTag = "\"median\": ";
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t name = line.find(nameTag);
+        size_t value = line.find(medianTag);
+        if (name == std::string::npos || value == std::string::npos)
+            continue;
+        name += nameTag.size();
+        medians[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + value + medianTag.size());
+    }
+    return medians;
+}
+
+//A scenario regresses when its median is slower than the baseline by more than the threshold.
+//Differences below a microsecond are timer noise and never count
+int compareWithBaseline(const std::string &filename, double threshold)
+{
+    std::map<std::string, double> baseline = readBaseline(filename);
+    int regressions = 0;
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "Comparison with " << filename << " (threshold " << threshold * 100.0 << "%)\n";
+    for (auto &&result : results)
+    {
+        double current = median(result.samples);
+        auto entry = baseline.find(result.name);
+        if (entry == baseline.end())
+        {
+            std::cout << "  " << std::left << std::setw(28) << result.name << current << " ms  (no baseline)\n";
+            continue;
+        }
+
+        double change = entry->second > 0.0 ? current / entry->second - 1.0 : 0.0;
+        bool regressed = change > threshold && current - entry->second > 0.001;
+        if (regressed)
+            regressions++;
+        std::cout << "  " << std::left << std::setw(28) << result.name << entry->second << " -> " << current << " ms  "
+                  << std::showpos << change * 100.0 << std::noshowpos << "%" << (regressed ? "  REGRESSION" : "") << '\n';
+    }
+    std::cout << regressions << " regression(s)\n";
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    std::string outputFilename;
+    std::string baselineFilename;
+    double threshold = 0.15;
+    bool cpuOnly = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            outputFilename = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+            baselineFilename = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            threshold = std::atof(argv[++i]);
+        else if (strcmp(argv[i], "--cpu-only") == 0)
+            cpuOnly = true;
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--output results.json] [--compare baseline.json] [--threshold 0.15] [--cpu-only]\n";
+            return 2;
+        }
+    }
+
+    benchScene();
+    benchMesh();
+    benchLod();
+    benchDrawList();
+
+    if (!cpuOnly)
+    {
+        headless = true;
+        useValidationLayers = false;
+
+        benchStartup();
+
+        width = resizeExtents[0].width;
+        height = resizeExtents[0].height;
+        startVulkan();
+        benchResize();
+        for (uint32_t drawCount : drawCounts)
+        {
+            benchFrames(drawCount);
+        }
+        benchPipelines();
+        shutdownVulkan();
+
+        benchOcclusionCulling();
+        sceneDrawCount = drawCounts[0];
+        benchLodFrames();
+    }
+
+    if (outputFilename.empty())
+    {
+        writeJson(std::cout);
+    }
+    else
+    {
+        std::ofstream file(outputFilename);
+        writeJson(file);
+        std::cout << "Results written to " << outputFilename << '\n';
+    }
+
+    if (!baselineFilename.empty() && compareWithBaseline(baselineFilename, threshold) > 0)
+        return 1;
+    return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+double millisecondsSince(Clock::time_point start);
+
+//Stores the samples of a scenario for the JSON output and the baseline comparison
+void addResult(const std::string &name, const std::vector<double> &samples);
+//Extra value written next to the timings of the last added scenario, e.g. a throughput
+void addMetric(const std::string &key, double value);
+double getLastMedian();
+
+//CPU only scenarios, need no Vulkan device
+void benchScene();
+void benchMesh();
+void benchLod();
+void benchDrawList();
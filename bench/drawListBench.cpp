@@ -0,0 +1,45 @@
+//Sorting a frame worth of draws: 100k opaque draws spread over a few pipelines and descriptor sets at
+//random depths, the same list is sorted again every iteration like the renderer does every frame. The random
+//keys variant uses every pipeline and descriptor set bit and half of the draws are translucent, so no key
+//bit is left out of the sort
+#include "bench.h"
+#include "../drawList.h"
+
+const uint32_t drawSortCount = 100000;
+const uint32_t drawSortPipelines = 8;
+const uint32_t drawSortDescriptorSets = 64;
+const uint32_t drawSortIterations = 50;
+
+static void benchSort(const char *name, uint32_t pipelines, uint32_t descriptorSets, bool someTranslucent)
+{
+    DrawList drawList;
+    uint32_t state = 3;
+    for (uint32_t i = 0; i < drawSortCount; i++)
+    {
+        DrawCommand command = {};
+        state = state * 1664525u + 1013904223u;
+        command.pipeline = (state >> 8) % pipelines;
+        state = state * 1664525u + 1013904223u;
+        command.descriptorSet = (state >> 8) % descriptorSets;
+        state = state * 1664525u + 1013904223u;
+        command.depth = 0.1f + 100.f * (state >> 8) / float(1 << 24);
+        command.translucent = someTranslucent && (state & 1);
+        addDraw(drawList, command);
+    }
+
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < drawSortIterations; i++)
+    {
+        auto start = Clock::now();
+        sortDrawList(drawList);
+        samples.push_back(millisecondsSince(start));
+    }
+    addResult(name, samples);
+    addMetric("draws", drawSortCount);
+}
+
+void benchDrawList()
+{
+    benchSort("draw_sort_100k", drawSortPipelines, drawSortDescriptorSets, false);
+    benchSort("draw_sort_100k_random_keys", 1u << DRAW_KEY_PIPELINE_BITS, 1u << DRAW_KEY_DESCRIPTOR_SET_BITS, true);
+}
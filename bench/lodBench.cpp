@@ -0,0 +1,129 @@
+//Level of detail: building the chains of a set of meshes, and picking levels for a scene where most instances
+//are far away. The instances drift back and forth a little every frame, which shows how often the
+//selection switches with and without hysteresis
+#include "bench.h"
+#include "../lod.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+const uint32_t lodMeshCount = 8;
+const uint32_t lodIterations = 3;
+const uint32_t lodInstanceCount = 100000;
+const uint32_t lodSelectFrames = 20;
+const float lodPixelsPerUnitNear = 2000.f; //One unit covers this many pixels at distance 1
+const float lodMaxPixelError = 1.f;
+const float lodHysteresis = 0.25f;
+
+//Spheres of different tessellation, each with a uv seam and poles
+static void buildSphere(uint32_t rings, uint32_t segments, MeshData &mesh)
+{
+    mesh = MeshData();
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            float theta = M_PI * ring / rings;
+            float phi = 2.0 * M_PI * segment / segments;
+            float position[3] = {sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)};
+            mesh.positions.insert(mesh.positions.end(), position, position + 3);
+            mesh.normals.insert(mesh.normals.end(), position, position + 3);
+            mesh.uvs.push_back(float(segment) / segments);
+            mesh.uvs.push_back(float(ring) / rings);
+        }
+    }
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            uint32_t a = ring * (segments + 1) + segment;
+            uint32_t b = a + segments + 1;
+            mesh.indices.insert(mesh.indices.end(), {a, b, b + 1, a, b + 1, a + 1});
+        }
+    }
+}
+
+static void buildMeshes(std::vector<MeshData> &meshes)
+{
+    meshes.resize(lodMeshCount);
+    for (uint32_t i = 0; i < lodMeshCount; i++)
+    {
+        buildSphere(100 + i * 20, 150 + i * 20, meshes[i]);
+    }
+}
+
+static void benchBuild(const char *name, uint32_t amountOfWorkers, std::vector<MeshData> &meshes)
+{
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < lodIterations; i++)
+    {
+        buildMeshes(meshes);
+        auto start = Clock::now();
+        buildLodChains(meshes, amountOfWorkers);
+        samples.push_back(millisecondsSince(start));
+    }
+    addResult(name, samples);
+}
+
+void benchLod()
+{
+    uint32_t amountOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<MeshData> meshes;
+    benchBuild("lod_build_1_thread", 1, meshes);
+    benchBuild("lod_build", amountOfWorkers, meshes);
+    uint32_t levels = 0;
+    for (const MeshData &mesh : meshes)
+    {
+        levels += mesh.lods.size();
+    }
+    addMetric("meshes", lodMeshCount);
+    addMetric("levels", levels);
+
+    //Distances from 1 to 100, seven in eight instances are further away than 25
+    std::vector<float> distances(lodInstanceCount);
+    uint32_t state = 7;
+    for (float &distance : distances)
+    {
+        state = state * 1664525u + 1013904223u;
+        float random = (state >> 8) / float(1 << 24);
+        distance = 1.f + 99.f * (1.f - random * random);
+    }
+
+    for (float hysteresis : {0.f, lodHysteresis})
+    {
+        std::vector<uint32_t> lods(lodInstanceCount, 0);
+        std::vector<double> samples;
+        double fullTriangles = 0.0, selectedTriangles = 0.0, largestPixelError = 0.0;
+        uint32_t switches = 0;
+        for (uint32_t frame = 0; frame < lodSelectFrames; frame++)
+        {
+            //One percent further away and closer in turns
+            float drift = frame % 2 == 0 ? 1.01f : 0.99f;
+            auto start = Clock::now();
+            for (uint32_t i = 0; i < lodInstanceCount; i++)
+            {
+                const MeshData &mesh = meshes[i % lodMeshCount];
+                float pixelsPerUnit = lodPixelsPerUnitNear / (distances[i] * drift);
+                uint32_t lod = selectLod(mesh.lods, pixelsPerUnit, lodMaxPixelError, hysteresis, lods[i]);
+                switches += lod != lods[i] && frame > 0 ? 1 : 0;
+                lods[i] = lod;
+            }
+            samples.push_back(millisecondsSince(start));
+
+            for (uint32_t i = 0; i < lodInstanceCount; i++)
+            {
+                const MeshData &mesh = meshes[i % lodMeshCount];
+                fullTriangles += mesh.lods[0].indexCount / 3;
+                selectedTriangles += mesh.lods[lods[i]].indexCount / 3;
+                double pixelError = mesh.lods[lods[i]].error * lodPixelsPerUnitNear / (distances[i] * drift);
+                largestPixelError = std::max(largestPixelError, pixelError);
+            }
+        }
+        addResult(hysteresis > 0.f ? "lod_select" : "lod_select_no_hysteresis", samples);
+        addMetric("triangles_full", fullTriangles / lodSelectFrames);
+        addMetric("triangles_selected", selectedTriangles / lodSelectFrames);
+        addMetric("largest_pixel_error", largestPixelError);
+        addMetric("switches_per_frame", double(switches) / (lodSelectFrames - 1));
+    }
+}
@@ -0,0 +1,162 @@
+//Mesh import: parsing, vertex merging and both reorderings of the loader, then quantization. The input is a
+//generated sphere with its quads in scattered order, written as OBJ and as binary glTF next to the benchmark
+#include "bench.h"
+#include "../meshLoader.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+const uint32_t meshRings = 400;
+const uint32_t meshSegments = 400;
+const uint32_t meshIterations = 5;
+const char *objFilename = "bench_mesh.obj";
+const char *glbFilename = "bench_mesh.glb";
+
+static void writeObj(const char *filename)
+{
+    std::ofstream file(filename);
+    file << std::fixed << std::setprecision(6);
+    for (uint32_t ring = 0; ring <= meshRings; ring++)
+    {
+        for (uint32_t segment = 0; segment <= meshSegments; segment++)
+        {
+            double theta = M_PI * ring / meshRings;
+            double phi = 2.0 * M_PI * segment / meshSegments;
+            double x = sin(theta) * cos(phi), y = cos(theta), z = sin(theta) * sin(phi);
+            file << "v " << x << ' ' << y << ' ' << z << '\n';
+            file << "vn " << x << ' ' << y << ' ' << z << '\n';
+            file << "vt " << double(segment) / meshSegments << ' ' << double(ring) / meshRings << '\n';
+        }
+    }
+
+    //Shuffled, so the vertex cache optimization has something to do
+    std::vector<uint32_t> quads(meshRings * meshSegments);
+    for (uint32_t i = 0; i < quads.size(); i++)
+    {
+        quads[i] = i;
+    }
+    uint32_t state = 5;
+    for (uint32_t i = quads.size() - 1; i > 0; i--)
+    {
+        state = state * 1664525u + 1013904223u;
+        std::swap(quads[i], quads[(state >> 8) % (i + 1)]);
+    }
+    for (uint32_t quad : quads)
+    {
+        uint32_t ring = quad / meshSegments;
+        uint32_t segment = quad % meshSegments;
+        uint32_t corners[4] = {ring * (meshSegments + 1) + segment + 1, 0, 0, 0};
+        corners[1] = corners[0] + meshSegments + 1;
+        corners[2] = corners[1] + 1;
+        corners[3] = corners[0] + 1;
+        file << 'f';
+        for (uint32_t corner : corners)
+        {
+            file << ' ' << corner << '/' << corner << '/' << corner;
+        }
+        file << '\n';
+    }
+}
+
+//One primitive with float attributes and 32 bit indices
+static void writeGlb(const char *filename, const MeshData &mesh)
+{
+    const uint32_t vertexCount = getVertexCount(mesh);
+    const size_t positionBytes = mesh.positions.size() * sizeof(float);
+    const size_t normalBytes = mesh.normals.size() * sizeof(float);
+    const size_t uvBytes = mesh.uvs.size() * sizeof(float);
+    const size_t indexBytes = mesh.indices.size() * sizeof(uint32_t);
+
+    char json[2048];
+    snprintf(json, sizeof(json),
+             "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":%zu}],"
+             "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+             "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+             "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},"
+             "{\"bufferView\":1,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},"
+             "{\"bufferView\":2,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},"
+             "{\"bufferView\":3,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}],"
+             "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}]}",
+             positionBytes + normalBytes + uvBytes + indexBytes, positionBytes, positionBytes, normalBytes,
+             positionBytes + normalBytes, uvBytes, positionBytes + normalBytes + uvBytes, indexBytes,
+             vertexCount, vertexCount, vertexCount, mesh.indices.size());
+    std::string jsonChunk = json;
+    while (jsonChunk.size() % 4 != 0)
+    {
+        jsonChunk += ' ';
+    }
+
+    uint32_t binSize = positionBytes + normalBytes + uvBytes + indexBytes;
+    uint32_t header[3] = {0x46546C67, 2, uint32_t(12 + 8 + jsonChunk.size() + 8 + binSize)};
+    uint32_t jsonHeader[2] = {uint32_t(jsonChunk.size()), 0x4E4F534A};
+    uint32_t binHeader[2] = {binSize, 0x004E4942};
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write((const char *)header, sizeof(header));
+    file.write((const char *)jsonHeader, sizeof(jsonHeader));
+    file.write(jsonChunk.data(), jsonChunk.size());
+    file.write((const char *)binHeader, sizeof(binHeader));
+    file.write((const char *)mesh.positions.data(), positionBytes);
+    file.write((const char *)mesh.normals.data(), normalBytes);
+    file.write((const char *)mesh.uvs.data(), uvBytes);
+    file.write((const char *)mesh.indices.data(), indexBytes);
+}
+
+static size_t getFileSize(const char *filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return size_t(file.tellg());
+}
+
+static void benchLoad(const char *name, const char *filename, uint32_t amountOfWorkers, MeshData &mesh)
+{
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < meshIterations; i++)
+    {
+        auto start = Clock::now();
+        loadMesh(filename, mesh, amountOfWorkers);
+        samples.push_back(millisecondsSince(start));
+    }
+    addResult(name, samples);
+
+    double megabytes = getFileSize(filename) / (1024.0 * 1024.0);
+    addMetric("file_mb", megabytes);
+    addMetric("mb_per_s", megabytes / (getLastMedian() / 1000.0));
+}
+
+void benchMesh()
+{
+    uint32_t amountOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    writeObj(objFilename);
+    {
+        //The glTF gets the merged but not yet reordered geometry of the OBJ
+        MappedFile file = mapFile(objFilename);
+        MeshData mesh;
+        parseObj(file.data, file.size, mesh, amountOfWorkers);
+        unmapFile(file);
+        writeGlb(glbFilename, mesh);
+    }
+
+    MeshData mesh;
+    benchLoad("mesh_load_obj", objFilename, amountOfWorkers, mesh);
+    benchLoad("mesh_load_glb", glbFilename, amountOfWorkers, mesh);
+
+    Mesh quantized;
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < meshIterations; i++)
+    {
+        auto start = Clock::now();
+        quantizeMesh(mesh, quantized);
+        samples.push_back(millisecondsSince(start));
+    }
+    addResult("mesh_quantize", samples);
+    addMetric("vertices", getVertexCount(mesh));
+    addMetric("vertex_bytes_float", getVertexCount(mesh) * (3 + 3 + 2) * sizeof(float));
+    addMetric("vertex_bytes_quantized", quantized.vertices.size() * sizeof(QuantizedVertex));
+
+    remove(objFilename);
+    remove(glbFilename);
+}
@@ -0,0 +1,272 @@
+//Scene transform update of the SoA scene store against a naive node graph, where every node is its own
+//allocation and the update follows child pointers. Both write the changed world matrices into a buffer
+//which stands in for the mapped transform buffer of the renderer
+#include "bench.h"
+#include "../scene.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+const uint32_t sceneTrees = 128;
+const uint32_t sceneNodesPerTree = 1024;
+const uint32_t sceneIterations = 30;
+const uint32_t sceneSparseChanges = sceneTrees * sceneNodesPerTree / 100;
+
+struct NaiveNode
+{
+    Transform local;
+    Matrix4 world;
+    float bounds[4];
+    float worldBounds[4];
+    NaiveNode *parent;
+    std::vector<NaiveNode *> children;
+    uint32_t index; //Position in the transform buffer
+    bool dirty;
+};
+
+struct SceneDescription
+{
+    std::vector<uint32_t> parents;
+    std::vector<Transform> transforms;
+};
+
+//Fixed seed, every run builds the same scene
+static uint32_t nextRandom(uint32_t &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+static float randomFloat(uint32_t &state, float min, float max)
+{
+    return min + (max - min) * (nextRandom(state) & 0xFFFF) / 65535.f;
+}
+
+static Transform randomTransform(uint32_t &state)
+{
+    Transform transform;
+    float length = 0.f;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        transform.rotation[i] = randomFloat(state, -1.f, 1.f);
+        length += transform.rotation[i] * transform.rotation[i];
+    }
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        transform.rotation[i] /= sqrtf(length);
+    }
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        transform.position[i] = randomFloat(state, -10.f, 10.f);
+        transform.scale[i] = randomFloat(state, 0.5f, 2.f);
+    }
+    return transform;
+}
+
+//Every node hangs below a random earlier node of its tree
+static SceneDescription describeScene()
+{
+    SceneDescription description;
+    uint32_t state = 1;
+    for (uint32_t tree = 0; tree < sceneTrees; tree++)
+    {
+        uint32_t root = description.parents.size();
+        for (uint32_t i = 0; i < sceneNodesPerTree; i++)
+        {
+            description.parents.push_back(i == 0 ? SCENE_NO_PARENT : root + nextRandom(state) % i);
+            description.transforms.push_back(randomTransform(state));
+        }
+    }
+    return description;
+}
+
+//Same trees, all of them hung below the root of the first one, like a scene with a single world node
+static SceneDescription describeSceneWithOneRoot()
+{
+    SceneDescription description = describeScene();
+    for (uint32_t tree = 1; tree < sceneTrees; tree++)
+    {
+        description.parents[tree * sceneNodesPerTree] = 0;
+    }
+    return description;
+}
+
+static void multiplyMatricesScalar(const Matrix4 &a, const Matrix4 &b, Matrix4 &out)
+{
+    for (uint32_t column = 0; column < 4; column++)
+    {
+        for (uint32_t row = 0; row < 4; row++)
+        {
+            float sum = 0.f;
+            for (uint32_t k = 0; k < 4; k++)
+            {
+                sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+            }
+            out.m[column * 4 + row] = sum;
+        }
+    }
+}
+
+static void updateNaiveNode(NaiveNode *node, bool parentChanged, Matrix4 *buffer)
+{
+    bool changed = node->dirty || parentChanged;
+    if (changed)
+    {
+        Matrix4 local;
+        composeMatrix(node->local, local);
+        if (node->parent)
+            multiplyMatricesScalar(node->parent->world, local, node->world);
+        else
+            node->world = local;
+
+        const float *m = node->world.m;
+        for (uint32_t row = 0; row < 3; row++)
+        {
+            node->worldBounds[row] = m[row] * node->bounds[0] + m[4 + row] * node->bounds[1] + m[8 + row] * node->bounds[2] + m[12 + row];
+        }
+        float scale = 0.f;
+        for (uint32_t column = 0; column < 3; column++)
+        {
+            const float *c = m + column * 4;
+            scale = std::max(scale, c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+        }
+        node->worldBounds[3] = node->bounds[3] * sqrtf(scale);
+
+        buffer[node->index] = node->world;
+        node->dirty = false;
+    }
+
+    for (NaiveNode *child : node->children)
+    {
+        updateNaiveNode(child, changed, buffer);
+    }
+}
+
+//Changes the local transform of amount random nodes, or of every root when amount is 0
+static std::vector<uint32_t> pickChanges(uint32_t amount, uint32_t &state)
+{
+    std::vector<uint32_t> changes;
+    if (amount == 0)
+    {
+        for (uint32_t tree = 0; tree < sceneTrees; tree++)
+        {
+            changes.push_back(tree * sceneNodesPerTree);
+        }
+        return changes;
+    }
+    for (uint32_t i = 0; i < amount; i++)
+    {
+        changes.push_back(nextRandom(state) % (sceneTrees * sceneNodesPerTree));
+    }
+    return changes;
+}
+
+static void benchSceneStore(const SceneDescription &description, const char *name, uint32_t changesPerIteration, uint32_t amountOfWorkers)
+{
+    const float bounds[4] = {0.f, 0.f, 0.f, 1.f};
+    SceneStore scene;
+    for (uint32_t i = 0; i < description.parents.size(); i++)
+    {
+        sceneAddNode(scene, description.parents[i], description.transforms[i], bounds);
+    }
+    std::vector<Matrix4> buffer(description.parents.size());
+    uint32_t bufferVersion = 0;
+    sceneUpdate(scene, amountOfWorkers);
+    sceneUploadWorldMatrices(scene, buffer.data(), bufferVersion);
+
+    uint32_t state = 7;
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < sceneIterations; i++)
+    {
+        for (uint32_t id : pickChanges(changesPerIteration, state))
+        {
+            Transform transform = description.transforms[id];
+            transform.position[0] += 0.01f * i;
+            sceneSetLocalTransform(scene, id, transform);
+        }
+
+        auto start = Clock::now();
+        sceneUpdate(scene, amountOfWorkers);
+        sceneUploadWorldMatrices(scene, buffer.data(), bufferVersion);
+        samples.push_back(millisecondsSince(start));
+    }
+    addResult(name, samples);
+}
+
+static void benchNaiveScene(const SceneDescription &description, const char *name, uint32_t changesPerIteration)
+{
+    const uint32_t count = description.parents.size();
+
+    //Allocated in a scattered order, as nodes created over the lifetime of an application would be
+    std::vector<std::unique_ptr<NaiveNode>> nodes(count);
+    uint32_t state = 3;
+    std::vector<uint32_t> allocationOrder(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        allocationOrder[i] = i;
+    }
+    for (uint32_t i = count - 1; i > 0; i--)
+    {
+        std::swap(allocationOrder[i], allocationOrder[nextRandom(state) % (i + 1)]);
+    }
+    for (uint32_t i : allocationOrder)
+    {
+        nodes[i].reset(new NaiveNode());
+    }
+
+    std::vector<NaiveNode *> roots;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        NaiveNode *node = nodes[i].get();
+        node->local = description.transforms[i];
+        node->bounds[0] = node->bounds[1] = node->bounds[2] = 0.f;
+        node->bounds[3] = 1.f;
+        node->index = i;
+        node->dirty = true;
+        node->parent = description.parents[i] == SCENE_NO_PARENT ? NULL : nodes[description.parents[i]].get();
+        if (node->parent)
+            node->parent->children.push_back(node);
+        else
+            roots.push_back(node);
+    }
+
+    std::vector<Matrix4> buffer(count);
+    for (NaiveNode *root : roots)
+    {
+        updateNaiveNode(root, false, buffer.data());
+    }
+
+    state = 7;
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < sceneIterations; i++)
+    {
+        for (uint32_t id : pickChanges(changesPerIteration, state))
+        {
+            nodes[id]->local = description.transforms[id];
+            nodes[id]->local.position[0] += 0.01f * i;
+            nodes[id]->dirty = true;
+        }
+
+        auto start = Clock::now();
+        for (NaiveNode *root : roots)
+        {
+            updateNaiveNode(root, false, buffer.data());
+        }
+        samples.push_back(millisecondsSince(start));
+    }
+    addResult(name, samples);
+}
+
+void benchScene()
+{
+    SceneDescription description = describeScene();
+    uint32_t amountOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    benchNaiveScene(description, "scene_naive_update_all", 0);
+    benchSceneStore(description, "scene_soa_update_all_1_thread", 0, 1);
+    benchSceneStore(description, "scene_soa_update_all", 0, amountOfWorkers);
+    benchSceneStore(describeSceneWithOneRoot(), "scene_soa_update_all_one_root", 0, amountOfWorkers);
+    benchNaiveScene(description, "scene_naive_update_1_percent", sceneSparseChanges);
+    benchSceneStore(description, "scene_soa_update_1_percent", sceneSparseChanges, amountOfWorkers);
+}
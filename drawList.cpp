@@ -0,0 +1,207 @@
+#include "drawList.h"
+#include <cstring>
+#include <utility>
+
+const uint32_t SORT_BITS = 64 - DRAW_KEY_COMMAND_BITS;
+const uint32_t RADIX_MAX_BITS = 12;
+const uint32_t MAX_BIT_RUNS = 3;
+
+//Contiguous runs of sort bits which differ between the keys, packed next to each other from bit 0 up. Run i is
+//sortBits & mask[i], it moves down by drop[i] bits when packed. Unused runs have an empty mask
+struct BitRuns
+{
+    uint64_t mask[MAX_BIT_RUNS];
+    uint32_t drop[MAX_BIT_RUNS];
+    uint32_t compactBits;
+};
+
+//Maps a float to the upper bits of an unsigned integer with the same ordering
+static uint64_t orderedDepthBits(float depth)
+{
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    return bits >> (32 - DRAW_KEY_DEPTH_BITS);
+}
+
+uint64_t makeDrawSortKey(uint32_t pipeline, uint32_t descriptorSet, float depth, bool translucent, uint32_t command)
+{
+    uint64_t pipelineBits = pipeline & ((1u << DRAW_KEY_PIPELINE_BITS) - 1);
+    uint64_t descriptorSetBits = descriptorSet & ((1u << DRAW_KEY_DESCRIPTOR_SET_BITS) - 1);
+    uint64_t depthBits = orderedDepthBits(depth);
+    uint64_t commandBits = command & (MAX_DRAW_COMMANDS - 1);
+
+    if (!translucent)
+        return (pipelineBits << 52) | (descriptorSetBits << 36) | (depthBits << 20) | commandBits;
+
+    uint64_t invertedDepthBits = ~depthBits & ((1u << DRAW_KEY_DEPTH_BITS) - 1);
+    return (1ull << 63) | (invertedDepthBits << 47) | (pipelineBits << 36) | (descriptorSetBits << 20) | commandBits;
+}
+
+//Splits the mask into its runs of set bits. Runs separated by the smallest gaps are merged until at most
+//MAX_BIT_RUNS are left, the gap bits are equal in every key and only cost a little bucket space
+static BitRuns getBitRuns(uint64_t mask)
+{
+    uint32_t first[SORT_BITS], width[SORT_BITS];
+    uint32_t runCount = 0;
+    uint32_t bit = 0;
+    while (bit < SORT_BITS)
+    {
+        if (!((mask >> bit) & 1))
+        {
+            bit++;
+            continue;
+        }
+        first[runCount] = bit;
+        while (bit < SORT_BITS && ((mask >> bit) & 1))
+            bit++;
+        width[runCount] = bit - first[runCount];
+        runCount++;
+    }
+
+    while (runCount > MAX_BIT_RUNS)
+    {
+        uint32_t smallest = 0;
+        for (uint32_t i = 1; i + 1 < runCount; i++)
+        {
+            if (first[i + 1] - first[i] - width[i] < first[smallest + 1] - first[smallest] - width[smallest])
+                smallest = i;
+        }
+        width[smallest] = first[smallest + 1] + width[smallest + 1] - first[smallest];
+        for (uint32_t i = smallest + 1; i + 1 < runCount; i++)
+        {
+            first[i] = first[i + 1];
+            width[i] = width[i + 1];
+        }
+        runCount--;
+    }
+
+    BitRuns runs;
+    runs.compactBits = 0;
+    for (uint32_t i = 0; i < MAX_BIT_RUNS; i++)
+    {
+        runs.mask[i] = i < runCount ? ((1ull << width[i]) - 1) << first[i] : 0;
+        runs.drop[i] = i < runCount ? first[i] - runs.compactBits : 0;
+        runs.compactBits += i < runCount ? width[i] : 0;
+    }
+    return runs;
+}
+
+static uint64_t compactKey(uint64_t sortBits, const BitRuns &runs)
+{
+    return ((sortBits & runs.mask[0]) >> runs.drop[0]) | ((sortBits & runs.mask[1]) >> runs.drop[1]) |
+           ((sortBits & runs.mask[2]) >> runs.drop[2]);
+}
+
+static uint64_t expandKey(uint64_t compact, const BitRuns &runs)
+{
+    return ((compact & (runs.mask[0] >> runs.drop[0])) << runs.drop[0]) |
+           ((compact & (runs.mask[1] >> runs.drop[1])) << runs.drop[1]) |
+           ((compact & (runs.mask[2] >> runs.drop[2])) << runs.drop[2]);
+}
+
+//Turns the counts of a digit into the position of the first key of each bucket
+static void prefixSum(uint32_t *histogram, uint32_t buckets)
+{
+    uint32_t offset = 0;
+    for (uint32_t bucket = 0; bucket < buckets; bucket++)
+    {
+        uint32_t amount = histogram[bucket];
+        histogram[bucket] = offset;
+        offset += amount;
+    }
+}
+
+//varyingBits has a bit set for every sort bit (key >> DRAW_KEY_COMMAND_BITS) that is not the same in all keys.
+//Only those bits are sorted: they are packed together first, so 100k keys of a few pipelines and descriptor sets
+//need two scatters instead of four. May swap keys and scratch
+static void radixSortDrawKeys(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch, uint64_t varyingBits)
+{
+    const size_t count = keys.size();
+    if (count < 2 || varyingBits == 0)
+        return;
+    scratch.resize(count);
+
+    const BitRuns runs = getBitRuns(varyingBits);
+    const uint32_t digitCount = (runs.compactBits + RADIX_MAX_BITS - 1) / RADIX_MAX_BITS;
+    const uint32_t digitBits = (runs.compactBits + digitCount - 1) / digitCount;
+    const uint32_t digitMask = (1u << digitBits) - 1;
+    const uint64_t constantBits = (keys[0] >> DRAW_KEY_COMMAND_BITS) & ~varyingBits;
+
+    //Packing the keys counts the first digit, every scatter but the last counts the digit after it
+    uint32_t histograms[2][1u << RADIX_MAX_BITS] = {};
+    uint64_t *src = scratch.data();
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t compact = compactKey(keys[i] >> DRAW_KEY_COMMAND_BITS, runs);
+        src[i] = (compact << DRAW_KEY_COMMAND_BITS) | getDrawSortKeyCommand(keys[i]);
+        histograms[0][compact & digitMask]++;
+    }
+
+    uint64_t *dst = keys.data();
+    for (uint32_t digit = 0; digit + 1 < digitCount; digit++)
+    {
+        const uint32_t shift = DRAW_KEY_COMMAND_BITS + digit * digitBits;
+        uint32_t *histogram = histograms[digit & 1];
+        uint32_t *nextHistogram = histograms[(digit + 1) & 1];
+        prefixSum(histogram, digitMask + 1);
+        memset(nextHistogram, 0, sizeof(uint32_t) * (digitMask + 1));
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t key = src[i];
+            dst[histogram[(key >> shift) & digitMask]++] = key;
+            nextHistogram[(key >> (shift + digitBits)) & digitMask]++;
+        }
+        std::swap(src, dst);
+    }
+
+    //The last scatter puts the keys back into their full layout
+    const uint32_t shift = DRAW_KEY_COMMAND_BITS + (digitCount - 1) * digitBits;
+    uint32_t *histogram = histograms[(digitCount - 1) & 1];
+    prefixSum(histogram, digitMask + 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t key = src[i];
+        uint64_t sortBits = constantBits | expandKey(key >> DRAW_KEY_COMMAND_BITS, runs);
+        dst[histogram[(key >> shift) & digitMask]++] = (sortBits << DRAW_KEY_COMMAND_BITS) | getDrawSortKeyCommand(key);
+    }
+    if (dst != keys.data())
+        keys.swap(scratch);
+}
+
+void radixSortDrawKeys(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch)
+{
+    uint64_t varyingBits = 0;
+    for (uint64_t key : keys)
+    {
+        varyingBits |= (key ^ keys[0]) >> DRAW_KEY_COMMAND_BITS;
+    }
+    radixSortDrawKeys(keys, scratch, varyingBits);
+}
+
+void clearDrawList(DrawList &drawList)
+{
+    drawList.commands.clear();
+    drawList.sorted.clear();
+}
+
+void addDraw(DrawList &drawList, const DrawCommand &command)
+{
+    if (drawList.commands.size() < MAX_DRAW_COMMANDS)
+        drawList.commands.push_back(command);
+}
+
+void sortDrawList(DrawList &drawList)
+{
+    drawList.sorted.resize(drawList.commands.size());
+    uint64_t firstKey = 0, varyingBits = 0;
+    for (size_t i = 0; i < drawList.commands.size(); i++)
+    {
+        const DrawCommand &command = drawList.commands[i];
+        uint64_t key = makeDrawSortKey(command.pipeline, command.descriptorSet, command.depth, command.translucent, i);
+        firstKey = i == 0 ? key : firstKey;
+        varyingBits |= (key ^ firstKey) >> DRAW_KEY_COMMAND_BITS;
+        drawList.sorted[i] = key;
+    }
+    radixSortDrawKeys(drawList.sorted, drawList.scratch, varyingBits);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//Key layout, sorted ascending. The low bits hold the index of the command, so only the
+//upper 44 bits take part in the sort and the key alone is moved around:
+//  opaque:      [63] 0 | [62:52] pipeline | [51:36] descriptor set | [35:20] depth, front to back | [19:0] command
+//  translucent: [63] 1 | [62:47] depth, back to front | [46:36] pipeline | [35:20] descriptor set | [19:0] command
+const uint32_t DRAW_KEY_COMMAND_BITS = 20;
+const uint32_t DRAW_KEY_DEPTH_BITS = 16;
+const uint32_t DRAW_KEY_DESCRIPTOR_SET_BITS = 16;
+const uint32_t DRAW_KEY_PIPELINE_BITS = 11;
+const uint32_t MAX_DRAW_COMMANDS = 1u << DRAW_KEY_COMMAND_BITS;
+
+struct DrawCommand
+{
+    uint32_t pipeline;      //Index into the pipeline table of the renderer
+    uint32_t descriptorSet; //Index into the descriptor set table of the renderer
+    float depth;            //View space distance, smaller is closer to the camera
+    bool translucent;
+    uint32_t transform;     //Slot of the world matrix in the transform buffer of the renderer
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+};
+
+struct DrawList
+{
+    std::vector<DrawCommand> commands;
+    std::vector<uint64_t> sorted;
+    std::vector<uint64_t> scratch;
+};
+
+uint64_t makeDrawSortKey(uint32_t pipeline, uint32_t descriptorSet, float depth, bool translucent, uint32_t command);
+
+inline uint32_t getDrawSortKeyCommand(uint64_t key)
+{
+    return key & (MAX_DRAW_COMMANDS - 1);
+}
+
+//LSD radix sort of the upper 44 bits. Only the bits which differ between the keys are sorted, packed into digits
+//of up to 12 bits, so a few pipelines and descriptor sets take two scatters. scratch may be swapped with keys
+void radixSortDrawKeys(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch);
+
+void clearDrawList(DrawList &drawList);
+void addDraw(DrawList &drawList, const DrawCommand &command);
+//Builds the keys and sorts them, afterwards drawList.sorted holds the submission order
+void sortDrawList(DrawList &drawList);
@@ -0,0 +1,50 @@
+#include "dynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+const double FRAME_TIME_SMOOTHING = 0.1;   //Weight of the newest frame
+const float SCALE_GAIN = 0.5f;             //Fraction of the distance to the ideal scale covered per frame
+const float SCALE_DEADBAND = 0.02f;        //Smaller corrections are noise
+const float SHRINK_RATIO = 0.8f;           //Reallocate smaller targets below this fraction of the allocated scale
+const float REALLOCATION_HEADROOM = 0.1f;  //Allocated above the wanted scale, so it can grow a bit without reallocation
+const uint32_t REALLOCATION_DELAY = 30;    //Frames the wanted scale has to stay outside of the allocation
+
+void updateDynamicResolution(DynamicResolution &resolution, double gpuFrameMs, float frameScale)
+{
+    if (gpuFrameMs <= 0.0 || frameScale <= 0.f)
+        return;
+
+    double fullScaleMs = gpuFrameMs / (frameScale * frameScale);
+    if (resolution.fullScaleFrameMs <= 0.0)
+        resolution.fullScaleFrameMs = fullScaleMs;
+    else
+        resolution.fullScaleFrameMs += (fullScaleMs - resolution.fullScaleFrameMs) * FRAME_TIME_SMOOTHING;
+
+    float idealScale = float(std::sqrt(resolution.targetFrameMs / resolution.fullScaleFrameMs));
+    bool clamped = idealScale <= resolution.minScale || idealScale >= resolution.maxScale;
+    idealScale = std::min(std::max(idealScale, resolution.minScale), resolution.maxScale);
+    //Bounds are always reached, small corrections in between are ignored
+    if (clamped && std::fabs(idealScale - resolution.scale) < SCALE_DEADBAND)
+        resolution.scale = idealScale;
+    else if (std::fabs(idealScale - resolution.scale) > SCALE_DEADBAND)
+        resolution.scale += (idealScale - resolution.scale) * SCALE_GAIN;
+    resolution.scale = std::min(std::max(resolution.scale, resolution.minScale), resolution.maxScale);
+}
+
+bool dynamicResolutionNeedsReallocation(DynamicResolution &resolution)
+{
+    bool grow = resolution.scale > resolution.allocatedScale;
+    bool shrink = resolution.scale < resolution.allocatedScale * SHRINK_RATIO;
+    if (!grow && !shrink)
+    {
+        resolution.framesOutsideAllocation = 0;
+        return false;
+    }
+
+    if (++resolution.framesOutsideAllocation < REALLOCATION_DELAY)
+        return false;
+
+    resolution.framesOutsideAllocation = 0;
+    resolution.allocatedScale = std::min(resolution.scale + REALLOCATION_HEADROOM, resolution.maxScale);
+    return true;
+}
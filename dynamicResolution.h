@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+//Picks the scene resolution from measured GPU frame times. Scales apply to width and height,
+//so the cost of a frame is roughly proportional to scale * scale
+struct DynamicResolution
+{
+    float minScale = 0.5f;
+    float maxScale = 1.f;
+    double targetFrameMs = 1000.0 / 60.0;
+
+    float scale = 1.f;          //Wanted scale of the next frames
+    float allocatedScale = 1.f; //Scale the offscreen targets were allocated for, frames never render above it
+    double fullScaleFrameMs = 0.0; //Smoothed estimate of the GPU time at scale 1
+    uint32_t framesOutsideAllocation = 0;
+};
+
+//Feeds the GPU time of a frame that was rendered at frameScale
+void updateDynamicResolution(DynamicResolution &resolution, double gpuFrameMs, float frameScale);
+
+//True if the offscreen targets should be allocated again for the new allocatedScale. Only happens after the
+//wanted scale stayed above the allocation or far enough below it for a while, never every frame
+bool dynamicResolutionNeedsReallocation(DynamicResolution &resolution);
+
+//Scale a frame can use right now
+inline float getDynamicResolutionRenderScale(const DynamicResolution &resolution)
+{
+    return resolution.scale < resolution.allocatedScale ? resolution.scale : resolution.allocatedScale;
+}
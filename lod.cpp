@@ -0,0 +1,590 @@
+#include "lod.h"
+#include "taskGraph.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+const uint32_t maxLodLevels = 8;
+const uint32_t minLodTriangles = 32;
+//A level is dropped if it still has more than this share of the triangles of the level before
+const float minLodReduction = 0.8f;
+//Open borders get a plane perpendicular to their triangle, weighted higher than the triangles themselves so
+//the outline of the mesh keeps its shape
+const double borderWeight = 10.0;
+//Triangles flatter than this, as height over longest edge, have no usable orientation. The quadrics barely weigh
+//them, and their planes are left out of the distances
+const double minPlaneTriangleHeight = 1e-4;
+
+//Symmetric 4x4 matrix summing the squared distances to a set of weighted planes
+struct Quadric
+{
+    double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+    double weight;
+};
+
+static void addPlane(Quadric &quadric, const double normal[3], double distance, double weight)
+{
+    const double a = normal[0], b = normal[1], c = normal[2], d = distance;
+    quadric.a00 += weight * a * a;
+    quadric.a01 += weight * a * b;
+    quadric.a02 += weight * a * c;
+    quadric.a03 += weight * a * d;
+    quadric.a11 += weight * b * b;
+    quadric.a12 += weight * b * c;
+    quadric.a13 += weight * b * d;
+    quadric.a22 += weight * c * c;
+    quadric.a23 += weight * c * d;
+    quadric.a33 += weight * d * d;
+    quadric.weight += weight;
+}
+
+static void addQuadric(Quadric &quadric, const Quadric &other)
+{
+    quadric.a00 += other.a00;
+    quadric.a01 += other.a01;
+    quadric.a02 += other.a02;
+    quadric.a03 += other.a03;
+    quadric.a11 += other.a11;
+    quadric.a12 += other.a12;
+    quadric.a13 += other.a13;
+    quadric.a22 += other.a22;
+    quadric.a23 += other.a23;
+    quadric.a33 += other.a33;
+    quadric.weight += other.weight;
+}
+
+//Mean squared distance of the point to the planes
+static double evaluateQuadric(const Quadric &quadric, const float point[3])
+{
+    if (quadric.weight <= 0.0)
+        return 0.0;
+
+    const double x = point[0], y = point[1], z = point[2];
+    double error = quadric.a00 * x * x + 2.0 * quadric.a01 * x * y + 2.0 * quadric.a02 * x * z + 2.0 * quadric.a03 * x +
+                   quadric.a11 * y * y + 2.0 * quadric.a12 * y * z + 2.0 * quadric.a13 * y +
+                   quadric.a22 * z * z + 2.0 * quadric.a23 * z + quadric.a33;
+    return std::max(error, 0.0) / quadric.weight;
+}
+
+const uint32_t noPlane = ~0u;
+
+//The planes of the full mesh around every position, as a list through next. Collapsing a position appends its
+//list to the one of the target, so a position knows every plane of the surface it stands in for
+struct PlaneLists
+{
+    std::vector<double> planes;   //Normal and distance, four per entry
+    std::vector<uint32_t> next;   //Per entry
+    std::vector<uint32_t> first;  //Per position
+    std::vector<uint32_t> last;   //Per position
+    std::vector<double> distance; //Per position, the largest distance of the position to its planes
+};
+
+static void addListPlane(PlaneLists &lists, uint32_t position, const double normal[3], double distance)
+{
+    uint32_t entry = lists.next.size();
+    lists.planes.insert(lists.planes.end(), {normal[0], normal[1], normal[2], distance});
+    lists.next.push_back(noPlane);
+    if (lists.first[position] == noPlane)
+        lists.first[position] = entry;
+    else
+        lists.next[lists.last[position]] = entry;
+    lists.last[position] = entry;
+}
+
+//Largest distance of the point to the planes of position
+static double largestPlaneDistance(const PlaneLists &lists, uint32_t position, const float point[3])
+{
+    double largest = 0.0;
+    for (uint32_t entry = lists.first[position]; entry != noPlane; entry = lists.next[entry])
+    {
+        const double *plane = &lists.planes[entry * 4];
+        largest = std::max(largest, fabs(plane[0] * point[0] + plane[1] * point[1] + plane[2] * point[2] + plane[3]));
+    }
+    return largest;
+}
+
+static void mergePlaneLists(PlaneLists &lists, uint32_t from, uint32_t to, double distance)
+{
+    lists.distance[to] = distance;
+    if (lists.first[from] == noPlane)
+        return;
+    if (lists.first[to] == noPlane)
+        lists.first[to] = lists.first[from];
+    else
+        lists.next[lists.last[to]] = lists.first[from];
+    lists.last[to] = lists.last[from];
+    lists.first[from] = noPlane;
+}
+
+static void cross(const double a[3], const double b[3], double result[3])
+{
+    result[0] = a[1] * b[2] - a[2] * b[1];
+    result[1] = a[2] * b[0] - a[0] * b[2];
+    result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static double dot(const double a[3], const double b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//Not normalized, the length is twice the area
+static void triangleNormal(const float *a, const float *b, const float *c, double normal[3])
+{
+    const double ab[3] = {double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2]};
+    const double ac[3] = {double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2]};
+    cross(ab, ac, normal);
+}
+
+struct PositionKey
+{
+    float position[3];
+
+    bool operator==(const PositionKey &other) const
+    {
+        return memcmp(position, other.position, sizeof(position)) == 0;
+    }
+};
+
+struct PositionKeyHash
+{
+    size_t operator()(const PositionKey &key) const
+    {
+        return hashBytes(key.position, sizeof(key.position));
+    }
+};
+
+//Vertices sharing a position (the copies along uv and normal seams) are simplified as one. The first of
+//them stands for the position, the others are listed as its wedges
+struct PositionGroups
+{
+    std::vector<uint32_t> positionOf;    //Per vertex, the vertex standing for its position
+    std::vector<uint32_t> wedgeOffsets;  //Per vertex, into wedges
+    std::vector<uint32_t> wedges;
+};
+
+static void groupPositions(const MeshData &mesh, PositionGroups &groups)
+{
+    const uint32_t vertexCount = getVertexCount(mesh);
+    std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstVertices;
+    firstVertices.reserve(vertexCount);
+    groups.positionOf.resize(vertexCount);
+    groups.wedgeOffsets.assign(vertexCount + 1, 0);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        PositionKey key;
+        memcpy(key.position, &mesh.positions[vertex * 3], sizeof(key.position));
+        uint32_t position = firstVertices.insert({key, vertex}).first->second;
+        groups.positionOf[vertex] = position;
+        groups.wedgeOffsets[position + 1]++;
+    }
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        groups.wedgeOffsets[vertex + 1] += groups.wedgeOffsets[vertex];
+    }
+    groups.wedges.resize(vertexCount);
+    std::vector<uint32_t> fill(groups.wedgeOffsets.begin(), groups.wedgeOffsets.end() - 1);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        groups.wedges[fill[groups.positionOf[vertex]]++] = vertex;
+    }
+}
+
+//The wedge at the target position whose normal and uv are closest to the ones of vertex
+static uint32_t findClosestWedge(const MeshData &mesh, const PositionGroups &groups, uint32_t vertex, uint32_t position)
+{
+    uint32_t closest = position;
+    float closestDistance = FLT_MAX;
+    for (uint32_t i = groups.wedgeOffsets[position]; i < groups.wedgeOffsets[position + 1]; i++)
+    {
+        uint32_t wedge = groups.wedges[i];
+        float distance = 0.f;
+        if (!mesh.normals.empty())
+        {
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                float difference = mesh.normals[wedge * 3 + axis] - mesh.normals[vertex * 3 + axis];
+                distance += difference * difference;
+            }
+        }
+        if (!mesh.uvs.empty())
+        {
+            for (uint32_t axis = 0; axis < 2; axis++)
+            {
+                float difference = mesh.uvs[wedge * 2 + axis] - mesh.uvs[vertex * 2 + axis];
+                distance += difference * difference;
+            }
+        }
+        if (distance < closestDistance)
+        {
+            closest = wedge;
+            closestDistance = distance;
+        }
+    }
+    return closest;
+}
+
+static void computeQuadrics(const MeshData &mesh, const PositionGroups &groups, const std::vector<uint32_t> &indices,
+                            std::vector<Quadric> &quadrics, PlaneLists &lists)
+{
+    quadrics.assign(getVertexCount(mesh), Quadric());
+    lists = PlaneLists();
+    lists.first.assign(getVertexCount(mesh), noPlane);
+    lists.last.assign(getVertexCount(mesh), noPlane);
+    lists.distance.assign(getVertexCount(mesh), 0.0);
+
+    //Edges between positions, counted in both directions. An edge used once lies on an open border
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    edgeUses.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            uint64_t a = groups.positionOf[indices[i + corner]];
+            uint64_t b = groups.positionOf[indices[i + (corner + 1) % 3]];
+            edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const uint32_t corners[3] = {groups.positionOf[indices[i]], groups.positionOf[indices[i + 1]],
+                                     groups.positionOf[indices[i + 2]]};
+        const float *points[3] = {&mesh.positions[corners[0] * 3], &mesh.positions[corners[1] * 3],
+                                  &mesh.positions[corners[2] * 3]};
+        double normal[3];
+        triangleNormal(points[0], points[1], points[2], normal);
+        double length = sqrt(dot(normal, normal));
+        if (length == 0.0)
+            continue;
+        normal[0] /= length;
+        normal[1] /= length;
+        normal[2] /= length;
+
+        double longestEdge = 0.0;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const float *from = points[corner];
+            const float *to = points[(corner + 1) % 3];
+            const double edge[3] = {double(to[0]) - from[0], double(to[1]) - from[1], double(to[2]) - from[2]};
+            longestEdge = std::max(longestEdge, dot(edge, edge));
+        }
+        bool flat = length < minPlaneTriangleHeight * longestEdge;
+
+        //Weighted by area, so many small triangles do not outvote a big one
+        const double point[3] = {points[0][0], points[0][1], points[0][2]};
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            addPlane(quadrics[corners[corner]], normal, -dot(normal, point), length * 0.5);
+            if (!flat)
+                addListPlane(lists, corners[corner], normal, -dot(normal, point));
+        }
+
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            uint64_t a = corners[corner];
+            uint64_t b = corners[(corner + 1) % 3];
+            if (edgeUses[std::min(a, b) << 32 | std::max(a, b)] != 1)
+                continue;
+
+            const float *from = points[corner];
+            const float *to = points[(corner + 1) % 3];
+            const double edge[3] = {double(to[0]) - from[0], double(to[1]) - from[1], double(to[2]) - from[2]};
+            double borderNormal[3];
+            cross(edge, normal, borderNormal);
+            double borderLength = sqrt(dot(borderNormal, borderNormal));
+            if (borderLength == 0.0)
+                continue;
+            borderNormal[0] /= borderLength;
+            borderNormal[1] /= borderLength;
+            borderNormal[2] /= borderLength;
+
+            const double fromPoint[3] = {from[0], from[1], from[2]};
+            double weight = dot(edge, edge) * borderWeight;
+            addPlane(quadrics[a], borderNormal, -dot(borderNormal, fromPoint), weight);
+            addPlane(quadrics[b], borderNormal, -dot(borderNormal, fromPoint), weight);
+            if (flat)
+                continue;
+            addListPlane(lists, a, borderNormal, -dot(borderNormal, fromPoint));
+            addListPlane(lists, b, borderNormal, -dot(borderNormal, fromPoint));
+        }
+    }
+}
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    double error; //Mean squared distance to the planes, never more than the largest distance squared
+};
+
+//What the simplification of one level leaves behind for the next one
+struct SimplifyState
+{
+    PositionGroups groups;
+    std::vector<Quadric> quadrics;
+    PlaneLists lists;
+};
+
+static void startSimplify(const MeshData &mesh, const std::vector<uint32_t> &indices, SimplifyState &state)
+{
+    groupPositions(mesh, state.groups);
+    computeQuadrics(mesh, state.groups, indices, state.quadrics, state.lists);
+}
+
+//True if moving from onto to turns one of the triangles around from over
+static bool collapseFlips(const MeshData &mesh, const std::vector<uint32_t> &positionTriangles,
+                          const std::vector<uint32_t> &positionTriangleOffsets, const std::vector<uint32_t> &triangles,
+                          const PositionGroups &groups, uint32_t from, uint32_t to)
+{
+    for (uint32_t i = positionTriangleOffsets[from]; i < positionTriangleOffsets[from + 1]; i++)
+    {
+        const uint32_t triangle = positionTriangles[i];
+        uint32_t corners[3];
+        bool removed = false;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            corners[corner] = groups.positionOf[triangles[triangle * 3 + corner]];
+            removed = removed || corners[corner] == to;
+        }
+        if (removed)
+            continue;
+
+        double before[3];
+        triangleNormal(&mesh.positions[corners[0] * 3], &mesh.positions[corners[1] * 3], &mesh.positions[corners[2] * 3], before);
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            if (corners[corner] == from)
+                corners[corner] = to;
+        }
+        double after[3];
+        triangleNormal(&mesh.positions[corners[0] * 3], &mesh.positions[corners[1] * 3], &mesh.positions[corners[2] * 3], after);
+        //More than about 75 degrees counts as well, slivers turned that far usually fold over a neighbour
+        if (dot(before, after) <= 0.25 * sqrt(dot(before, before) * dot(after, after)))
+            return true;
+    }
+    return false;
+}
+
+//Simplifies indices further, the state holds the quadrics and planes left by the collapses that led to them.
+//Returns the largest distance of a vertex to the planes of the mesh the state was started with
+static double simplifyLevel(const MeshData &mesh, SimplifyState &state, const std::vector<uint32_t> &indices,
+                            uint32_t targetIndexCount, float maxError, std::vector<uint32_t> &result)
+{
+    const uint32_t vertexCount = getVertexCount(mesh);
+    const PositionGroups &groups = state.groups;
+    std::vector<Quadric> &quadrics = state.quadrics;
+    PlaneLists &lists = state.lists;
+
+    std::vector<uint32_t> triangles(indices);
+    const double errorLimit = double(maxError) * maxError;
+    double largestDistance = 0.0;
+    for (uint32_t vertex : indices)
+    {
+        largestDistance = std::max(largestDistance, lists.distance[groups.positionOf[vertex]]);
+    }
+
+    std::vector<uint64_t> edges;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> positionTriangleOffsets(vertexCount + 1);
+    std::vector<uint32_t> positionTriangles;
+    std::vector<uint32_t> collapsedTo(vertexCount);
+    std::vector<bool> locked(vertexCount);
+
+    //Every pass collapses the cheapest edges whose surroundings were not touched yet in this pass, then
+    //rewrites the triangles. Later passes see the merged quadrics
+    while (triangles.size() > targetIndexCount)
+    {
+        edges.clear();
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint64_t a = groups.positionOf[triangles[i + corner]];
+                uint64_t b = groups.positionOf[triangles[i + (corner + 1) % 3]];
+                edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (uint64_t edge : edges)
+        {
+            uint32_t a = edge >> 32;
+            uint32_t b = edge & 0xFFFFFFFF;
+            Quadric merged = quadrics[a];
+            addQuadric(merged, quadrics[b]);
+            double errorAToB = evaluateQuadric(merged, &mesh.positions[b * 3]);
+            double errorBToA = evaluateQuadric(merged, &mesh.positions[a * 3]);
+            if (errorAToB <= errorBToA)
+                collapses.push_back({a, b, errorAToB});
+            else
+                collapses.push_back({b, a, errorBToA});
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+        //Triangles around every position
+        std::fill(positionTriangleOffsets.begin(), positionTriangleOffsets.end(), 0);
+        for (uint32_t vertex : triangles)
+        {
+            positionTriangleOffsets[groups.positionOf[vertex] + 1]++;
+        }
+        for (uint32_t position = 0; position < vertexCount; position++)
+        {
+            positionTriangleOffsets[position + 1] += positionTriangleOffsets[position];
+        }
+        positionTriangles.resize(triangles.size());
+        std::vector<uint32_t> fill(positionTriangleOffsets.begin(), positionTriangleOffsets.end() - 1);
+        for (size_t i = 0; i < triangles.size(); i++)
+        {
+            positionTriangles[fill[groups.positionOf[triangles[i]]]++] = i / 3;
+        }
+
+        for (uint32_t position = 0; position < vertexCount; position++)
+        {
+            collapsedTo[position] = position;
+        }
+        std::fill(locked.begin(), locked.end(), false);
+
+        const size_t trianglesToRemove = (triangles.size() - targetIndexCount + 2) / 3;
+        size_t removedTriangles = 0;
+        uint32_t collapseCount = 0;
+        for (const Collapse &collapse : collapses)
+        {
+            if (collapse.error > errorLimit || removedTriangles >= trianglesToRemove)
+                break;
+            if (locked[collapse.from] || locked[collapse.to])
+                continue;
+            if (collapseFlips(mesh, positionTriangles, positionTriangleOffsets, triangles, groups, collapse.from, collapse.to))
+                continue;
+            //The planes of to already went through its position, only the ones of from are new to it
+            const double distance = std::max(lists.distance[collapse.to],
+                                             largestPlaneDistance(lists, collapse.from, &mesh.positions[collapse.to * 3]));
+            if (distance > maxError)
+                continue;
+
+            //Everything around from changes shape, so none of it may move again in this pass
+            for (uint32_t i = positionTriangleOffsets[collapse.from]; i < positionTriangleOffsets[collapse.from + 1]; i++)
+            {
+                const uint32_t triangle = positionTriangles[i];
+                bool removed = false;
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t position = groups.positionOf[triangles[triangle * 3 + corner]];
+                    locked[position] = true;
+                    removed = removed || position == collapse.to;
+                }
+                removedTriangles += removed ? 1 : 0;
+            }
+            locked[collapse.to] = true;
+
+            collapsedTo[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            mergePlaneLists(lists, collapse.from, collapse.to, distance);
+            largestDistance = std::max(largestDistance, distance);
+            collapseCount++;
+        }
+        if (collapseCount == 0)
+            break;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            uint32_t corners[3];
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = triangles[i + corner];
+                uint32_t position = collapsedTo[groups.positionOf[vertex]];
+                corners[corner] = position == groups.positionOf[vertex] ? vertex : findClosestWedge(mesh, groups, vertex, position);
+            }
+            uint32_t a = groups.positionOf[corners[0]];
+            uint32_t b = groups.positionOf[corners[1]];
+            uint32_t c = groups.positionOf[corners[2]];
+            if (a == b || b == c || a == c)
+                continue;
+
+            triangles[kept++] = corners[0];
+            triangles[kept++] = corners[1];
+            triangles[kept++] = corners[2];
+        }
+        triangles.resize(kept);
+    }
+
+    result.swap(triangles);
+    return largestDistance;
+}
+
+float simplifyMesh(const MeshData &mesh, const std::vector<uint32_t> &indices, uint32_t targetIndexCount,
+                   float maxError, std::vector<uint32_t> &result)
+{
+    SimplifyState state;
+    startSimplify(mesh, indices, state);
+    return simplifyLevel(mesh, state, indices, targetIndexCount, maxError, result);
+}
+
+void buildLodChain(MeshData &mesh)
+{
+    const uint32_t vertexCount = getVertexCount(mesh);
+    mesh.lods.assign(1, MeshLod{0, uint32_t(mesh.indices.size()), 0.f});
+
+    std::vector<uint32_t> level(mesh.indices);
+    std::vector<uint32_t> simplified;
+    //Each level is simplified from the one before, but the quadrics and planes carry over, so the errors are
+    //measured against the full mesh
+    SimplifyState state;
+    startSimplify(mesh, level, state);
+    while (mesh.lods.size() < maxLodLevels && level.size() / 3 >= minLodTriangles * 2)
+    {
+        uint32_t targetIndexCount = level.size() / 6 * 3;
+        float error = simplifyLevel(mesh, state, level, targetIndexCount, FLT_MAX, simplified);
+        if (simplified.size() > level.size() * minLodReduction)
+            break;
+
+        optimizeVertexCache(simplified, vertexCount);
+        mesh.lods.push_back({uint32_t(mesh.indices.size()), uint32_t(simplified.size()), error});
+        mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+        level.swap(simplified);
+    }
+}
+
+void buildLodChains(std::vector<MeshData> &meshes, uint32_t amountOfWorkers)
+{
+    if (amountOfWorkers <= 1 || meshes.size() <= 1)
+    {
+        for (MeshData &mesh : meshes)
+        {
+            buildLodChain(mesh);
+        }
+        return;
+    }
+
+    TaskGraph build;
+    for (MeshData &mesh : meshes)
+    {
+        taskGraphAdd(build, "lodChain", [&mesh]() { buildLodChain(mesh); });
+    }
+    runTaskGraph(build, std::min<size_t>(amountOfWorkers, meshes.size()) - 1);
+}
+
+uint32_t selectLod(const std::vector<MeshLod> &lods, float pixelsPerUnit, float maxPixelError, float hysteresis,
+                   uint32_t currentLod)
+{
+    //The errors grow from level to level
+    uint32_t lod = 0;
+    while (lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= maxPixelError)
+    {
+        lod++;
+    }
+    if (lod <= currentLod)
+        return lod;
+
+    uint32_t coarser = currentLod;
+    while (coarser < lod && lods[coarser + 1].error * pixelsPerUnit <= maxPixelError * (1.f - hysteresis))
+    {
+        coarser++;
+    }
+    return coarser;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "mesh.h"
+
+//Collapses edges in the order of their quadric error (Garland and Heckbert, "Surface Simplification Using
+//Quadric Error Metrics") until at most targetIndexCount indices are left. Collapses which would move a vertex
+//further than maxError from the planes of the triangles it replaces are skipped. A collapse moves a vertex onto a
+//neighbour, so the result indexes the vertices of the mesh.
+//Vertices on uv or normal seams move together with the other vertices at their position.
+//Returns the largest of those distances, in the units of the positions
+float simplifyMesh(const MeshData &mesh, const std::vector<uint32_t> &indices, uint32_t targetIndexCount,
+                   float maxError, std::vector<uint32_t> &result);
+
+//Appends levels with about half the triangles of the level before to mesh.indices and fills mesh.lods.
+//Stops at a few dozen triangles or once the simplification gets stuck
+void buildLodChain(MeshData &mesh);
+//One task per mesh
+void buildLodChains(std::vector<MeshData> &meshes, uint32_t amountOfWorkers);
+
+//Coarsest level whose error, multiplied by pixelsPerUnit, stays within maxPixelError. Going coarser than
+//currentLod needs the error to stay within maxPixelError * (1 - hysteresis), so an instance near a threshold
+//does not switch back and forth every frame. Going finer happens right away
+uint32_t selectLod(const std::vector<MeshLod> &lods, float pixelsPerUnit, float maxPixelError, float hysteresis,
+                   uint32_t currentLod);
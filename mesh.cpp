@@ -0,0 +1,438 @@
+#include "mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+struct VertexKey
+{
+    float values[8];
+
+    bool operator==(const VertexKey &other) const
+    {
+        return memcmp(values, other.values, sizeof(values)) == 0;
+    }
+};
+
+struct VertexKeyHash
+{
+    size_t operator()(const VertexKey &key) const
+    {
+        return hashBytes(key.values, sizeof(key.values));
+    }
+};
+
+void deduplicateVertices(MeshData &mesh)
+{
+    const uint32_t vertexCount = getVertexCount(mesh);
+    const bool hasNormals = !mesh.normals.empty();
+    const bool hasUvs = !mesh.uvs.empty();
+
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> uniqueVertices;
+    uniqueVertices.reserve(vertexCount);
+    std::vector<uint32_t> remap(vertexCount);
+    MeshData unique;
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        VertexKey key;
+        memset(&key, 0, sizeof(key));
+        memcpy(key.values, &mesh.positions[vertex * 3], 3 * sizeof(float));
+        if (hasNormals)
+            memcpy(key.values + 3, &mesh.normals[vertex * 3], 3 * sizeof(float));
+        if (hasUvs)
+            memcpy(key.values + 6, &mesh.uvs[vertex * 2], 2 * sizeof(float));
+
+        auto inserted = uniqueVertices.insert({key, getVertexCount(unique)});
+        remap[vertex] = inserted.first->second;
+        if (!inserted.second)
+            continue;
+
+        unique.positions.insert(unique.positions.end(), key.values, key.values + 3);
+        if (hasNormals)
+            unique.normals.insert(unique.normals.end(), key.values + 3, key.values + 6);
+        if (hasUvs)
+            unique.uvs.insert(unique.uvs.end(), key.values + 6, key.values + 8);
+    }
+
+    for (uint32_t &index : mesh.indices)
+    {
+        index = remap[index];
+    }
+    mesh.positions.swap(unique.positions);
+    mesh.normals.swap(unique.normals);
+    mesh.uvs.swap(unique.uvs);
+}
+
+void computeNormals(MeshData &mesh)
+{
+    mesh.normals.assign(mesh.positions.size(), 0.f);
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        const float *a = &mesh.positions[mesh.indices[i] * 3];
+        const float *b = &mesh.positions[mesh.indices[i + 1] * 3];
+        const float *c = &mesh.positions[mesh.indices[i + 2] * 3];
+        float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        //Not normalized, so bigger triangles count more
+        float normal[3] = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0]};
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            float *target = &mesh.normals[mesh.indices[i + corner] * 3];
+            target[0] += normal[0];
+            target[1] += normal[1];
+            target[2] += normal[2];
+        }
+    }
+
+    for (size_t i = 0; i < mesh.normals.size(); i += 3)
+    {
+        float *normal = &mesh.normals[i];
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0.f)
+        {
+            normal[0] /= length;
+            normal[1] /= length;
+            normal[2] /= length;
+        }
+        else
+        {
+            normal[2] = 1.f;
+        }
+    }
+}
+
+//Tuning values of the original article
+const uint32_t vertexCacheSize = 32;
+const float cacheDecayPower = 1.5f;
+const float lastTriangleScore = 0.75f;
+const float valenceBoostScale = 2.f;
+const float valenceBoostPower = 0.5f;
+
+const uint32_t maxValenceScored = 64;
+
+struct VertexScoreTable
+{
+    float cache[vertexCacheSize];
+    float valence[maxValenceScored];
+};
+
+//pow is too slow for the inner loop, every score it can produce is looked up
+static VertexScoreTable makeVertexScoreTable()
+{
+    VertexScoreTable table;
+    for (uint32_t position = 0; position < vertexCacheSize; position++)
+    {
+        if (position < 3)
+        {
+            //The triangle just drawn, using it again does not gain much
+            table.cache[position] = lastTriangleScore;
+        }
+        else
+        {
+            const float scaler = 1.f / (vertexCacheSize - 3);
+            table.cache[position] = powf(1.f - (position - 3) * scaler, cacheDecayPower);
+        }
+    }
+    table.valence[0] = 0.f;
+    for (uint32_t valence = 1; valence < maxValenceScored; valence++)
+    {
+        table.valence[valence] = valenceBoostScale * powf(float(valence), -valenceBoostPower);
+    }
+    return table;
+}
+
+static float scoreVertex(const VertexScoreTable &table, int32_t cachePosition, uint32_t remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.f;
+
+    float score = cachePosition >= 0 ? table.cache[cachePosition] : 0.f;
+    //Vertices with few triangles left are finished first, so they leave the working set
+    return score + table.valence[std::min(remainingTriangles, maxValenceScored - 1)];
+}
+
+void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount)
+{
+    const uint32_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    //Triangles of every vertex, as offsets into one array
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+    for (uint32_t index : indices)
+    {
+        triangleOffsets[index + 1]++;
+    }
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        triangleOffsets[vertex + 1] += triangleOffsets[vertex];
+    }
+    std::vector<uint32_t> remainingTriangles(vertexCount);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        remainingTriangles[vertex] = triangleOffsets[vertex + 1] - triangleOffsets[vertex];
+    }
+    std::vector<uint32_t> vertexTriangles(indices.size());
+    std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+    for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            vertexTriangles[fill[indices[triangle * 3 + corner]]++] = triangle;
+        }
+    }
+
+    static const VertexScoreTable scoreTable = makeVertexScoreTable();
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        vertexScores[vertex] = scoreVertex(scoreTable, -1, remainingTriangles[vertex]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        const uint32_t *corners = &indices[triangle * 3];
+        triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+    }
+
+    std::vector<uint32_t> optimized;
+    optimized.reserve(indices.size());
+    //One extra slot for each of the three vertices pushed in front
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(vertexCacheSize + 3);
+    newCache.reserve(vertexCacheSize + 3);
+    uint32_t nextUnemitted = 0;
+    int64_t bestTriangle = -1;
+
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        //Nothing in the cache has triangles left, continue with the next triangle in input order
+        if (bestTriangle < 0)
+        {
+            while (emitted[nextUnemitted])
+            {
+                nextUnemitted++;
+            }
+            bestTriangle = nextUnemitted;
+        }
+
+        const uint32_t *corners = &indices[bestTriangle * 3];
+        optimized.insert(optimized.end(), corners, corners + 3);
+        emitted[bestTriangle] = true;
+
+        //The three vertices go to the front of the cache, the rest keeps its order
+        newCache.assign(corners, corners + 3);
+        for (uint32_t vertex : cache)
+        {
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                newCache.push_back(vertex);
+        }
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = corners[corner];
+            uint32_t *triangles = &vertexTriangles[triangleOffsets[vertex]];
+            uint32_t amount = remainingTriangles[vertex];
+            for (uint32_t i = 0; i < amount; i++)
+            {
+                if (triangles[i] == bestTriangle)
+                {
+                    triangles[i] = triangles[amount - 1];
+                    break;
+                }
+            }
+            remainingTriangles[vertex]--;
+        }
+
+        //Rescore everything whose cache position changed, including the vertices that fell out
+        for (uint32_t i = 0; i < newCache.size(); i++)
+        {
+            uint32_t vertex = newCache[i];
+            cachePositions[vertex] = i < vertexCacheSize ? int32_t(i) : -1;
+            float score = scoreVertex(scoreTable, cachePositions[vertex], remainingTriangles[vertex]);
+            float change = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            uint32_t *triangles = &vertexTriangles[triangleOffsets[vertex]];
+            for (uint32_t t = 0; t < remainingTriangles[vertex]; t++)
+            {
+                triangleScores[triangles[t]] += change;
+            }
+        }
+        if (newCache.size() > vertexCacheSize)
+            newCache.resize(vertexCacheSize);
+        cache.swap(newCache);
+
+        //The next triangle is one that uses a vertex in the cache
+        bestTriangle = -1;
+        float bestScore = -1.f;
+        for (uint32_t vertex : cache)
+        {
+            uint32_t *triangles = &vertexTriangles[triangleOffsets[vertex]];
+            for (uint32_t t = 0; t < remainingTriangles[vertex]; t++)
+            {
+                if (triangleScores[triangles[t]] > bestScore)
+                {
+                    bestScore = triangleScores[triangles[t]];
+                    bestTriangle = triangles[t];
+                }
+            }
+        }
+    }
+
+    indices.swap(optimized);
+}
+
+void optimizeVertexFetch(MeshData &mesh)
+{
+    const uint32_t vertexCount = getVertexCount(mesh);
+    const uint32_t unused = 0xFFFFFFFFu;
+    std::vector<uint32_t> remap(vertexCount, unused);
+    uint32_t nextVertex = 0;
+    for (uint32_t &index : mesh.indices)
+    {
+        if (remap[index] == unused)
+            remap[index] = nextVertex++;
+        index = remap[index];
+    }
+
+    //Vertices no triangle uses are dropped
+    MeshData reordered;
+    reordered.positions.resize(nextVertex * 3);
+    reordered.normals.resize(mesh.normals.empty() ? 0 : nextVertex * 3);
+    reordered.uvs.resize(mesh.uvs.empty() ? 0 : nextVertex * 2);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        uint32_t target = remap[vertex];
+        if (target == unused)
+            continue;
+        memcpy(&reordered.positions[target * 3], &mesh.positions[vertex * 3], 3 * sizeof(float));
+        if (!mesh.normals.empty())
+            memcpy(&reordered.normals[target * 3], &mesh.normals[vertex * 3], 3 * sizeof(float));
+        if (!mesh.uvs.empty())
+            memcpy(&reordered.uvs[target * 2], &mesh.uvs[vertex * 2], 2 * sizeof(float));
+    }
+    mesh.positions.swap(reordered.positions);
+    mesh.normals.swap(reordered.normals);
+    mesh.uvs.swap(reordered.uvs);
+}
+
+static int16_t toSnorm16(float value)
+{
+    value = std::min(std::max(value, -1.f), 1.f);
+    return int16_t(lroundf(value * 32767.f));
+}
+
+void encodeOctahedral(const float normal[3], int16_t encoded[2])
+{
+    float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    if (length == 0.f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+    float x = normal[0] / length;
+    float y = normal[1] / length;
+    //The lower half is folded over the diagonals onto the outer triangles of the square
+    if (normal[2] < 0.f)
+    {
+        float foldedX = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+        float foldedY = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+        x = foldedX;
+        y = foldedY;
+    }
+    encoded[0] = toSnorm16(x);
+    encoded[1] = toSnorm16(y);
+}
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = int32_t((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (exponent >= 31)
+    {
+        //Too big, infinity, or NaN which keeps a mantissa bit
+        bool nan = ((bits >> 23) & 0xFF) == 0xFF && mantissa != 0;
+        return sign | 0x7C00u | (nan ? 0x200u : 0u);
+    }
+    if (exponent <= 0)
+    {
+        //Denormal or zero
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000u;
+        uint32_t shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return sign | half;
+    }
+
+    uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    //Round to nearest even, a carry into the exponent is still correct
+    uint32_t rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1)))
+        half++;
+    return half;
+}
+
+void quantizeMesh(const MeshData &data, Mesh &mesh)
+{
+    const uint32_t vertexCount = getVertexCount(data);
+    float minimum[3] = {0.f, 0.f, 0.f};
+    float maximum[3] = {0.f, 0.f, 0.f};
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            float value = data.positions[vertex * 3 + axis];
+            minimum[axis] = vertex == 0 ? value : std::min(minimum[axis], value);
+            maximum[axis] = vertex == 0 ? value : std::max(maximum[axis], value);
+        }
+    }
+
+    float inverseScale[3];
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        mesh.positionOffset[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+        mesh.positionScale[axis] = std::max((maximum[axis] - minimum[axis]) * 0.5f, 1e-20f);
+        inverseScale[axis] = 1.f / mesh.positionScale[axis];
+    }
+
+    float radius = 0.f;
+    mesh.vertices.resize(vertexCount);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        const float *position = &data.positions[vertex * 3];
+        QuantizedVertex &quantized = mesh.vertices[vertex];
+        float distance = 0.f;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            float centered = position[axis] - mesh.positionOffset[axis];
+            quantized.position[axis] = toSnorm16(centered * inverseScale[axis]);
+            distance += centered * centered;
+        }
+        quantized.position[3] = 0;
+        radius = std::max(radius, distance);
+
+        const float up[3] = {0.f, 0.f, 1.f};
+        encodeOctahedral(data.normals.empty() ? up : &data.normals[vertex * 3], quantized.normal);
+        quantized.uv[0] = floatToHalf(data.uvs.empty() ? 0.f : data.uvs[vertex * 2]);
+        quantized.uv[1] = floatToHalf(data.uvs.empty() ? 0.f : data.uvs[vertex * 2 + 1]);
+    }
+
+    mesh.bounds[0] = mesh.positionOffset[0];
+    mesh.bounds[1] = mesh.positionOffset[1];
+    mesh.bounds[2] = mesh.positionOffset[2];
+    mesh.bounds[3] = sqrtf(radius);
+    mesh.indices = data.indices;
+    mesh.lods = data.lods;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Range of the index buffer drawing one level of detail. All levels index the same vertices
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error; //Largest distance of a vertex to the planes of the full mesh triangles it replaces, in the units of the positions
+};
+
+//Full precision geometry as it comes out of the loaders. Normals and uvs are either empty or one per position
+struct MeshData
+{
+    std::vector<float> positions; //xyz
+    std::vector<float> normals;   //xyz
+    std::vector<float> uvs;       //uv
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods; //Filled by buildLodChain (lod.h), level 0 is the full mesh
+};
+
+//16 bytes instead of the 32 of three float positions, three float normals and two float uvs. The vertex input
+//state decodes it: position R16G16B16A16_SNORM (w unused), normal R16G16_SNORM octahedral, uv R16G16_SFLOAT
+struct QuantizedVertex
+{
+    int16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+};
+
+struct Mesh
+{
+    std::vector<QuantizedVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    //position = decoded position * positionScale + positionOffset
+    float positionScale[3];
+    float positionOffset[3];
+    float bounds[4]; //Bounding sphere, center and radius
+};
+
+inline uint32_t getVertexCount(const MeshData &mesh)
+{
+    return mesh.positions.size() / 3;
+}
+
+//FNV-1a over the bytes, for hash maps keyed by bit exact vertex attributes
+inline uint64_t hashBytes(const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+//Merges vertices whose position, normal and uv are bit for bit the same
+void deduplicateVertices(MeshData &mesh);
+
+//Smooth normals weighted by triangle area, for files without normals
+void computeNormals(MeshData &mesh);
+
+//Reorders the triangles for a post transform vertex cache (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation")
+void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+//Reorders the vertices by their first use in the index buffer, so vertex fetches walk forward through memory
+void optimizeVertexFetch(MeshData &mesh);
+
+void quantizeMesh(const MeshData &data, Mesh &mesh);
+
+void encodeOctahedral(const float normal[3], int16_t encoded[2]);
+uint16_t floatToHalf(float value);
@@ -0,0 +1,915 @@
+#include "meshLoader.h"
+#include "taskGraph.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+//Chunks smaller than this are not worth a task
+const size_t minObjChunkSize = 1 << 20;
+
+MappedFile mapFile(const std::string &filename)
+{
+    int descriptor = open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        throw std::runtime_error("Failed to open file " + filename);
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        close(descriptor);
+        throw std::runtime_error("Failed to read size of " + filename);
+    }
+
+    MappedFile file;
+    file.size = status.st_size;
+    if (file.size > 0)
+    {
+        void *data = mmap(NULL, file.size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED)
+        {
+            close(descriptor);
+            throw std::runtime_error("Failed to map " + filename);
+        }
+        //The parsers read front to back
+        madvise(data, file.size, MADV_SEQUENTIAL);
+        file.data = (const char *)data;
+    }
+    //The mapping stays valid without the descriptor
+    close(descriptor);
+    return file;
+}
+
+void unmapFile(MappedFile &file)
+{
+    if (file.data)
+        munmap((void *)file.data, file.size);
+    file.data = NULL;
+    file.size = 0;
+}
+
+//OBJ
+
+//Indices are stored 0 based. Absolute ones are >= 0, relative ones (negative in the file) are relative to the
+//chunk and offset by objRelativeBase until the counts of the earlier chunks are known
+const int32_t objMissingIndex = INT32_MIN;
+const int32_t objRelativeBase = 0x40000000;
+
+struct ObjCorner
+{
+    int32_t position;
+    int32_t uv;
+    int32_t normal;
+
+    bool operator==(const ObjCorner &other) const
+    {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
+
+struct ObjCornerHash
+{
+    size_t operator()(const ObjCorner &corner) const
+    {
+        uint64_t hash = uint32_t(corner.position) * 0x9E3779B97F4A7C15ull;
+        hash ^= (uint32_t(corner.uv) + (hash << 6) + (hash >> 2)) * 0xC2B2AE3D27D4EB4Full;
+        hash ^= (uint32_t(corner.normal) + (hash << 6) + (hash >> 2)) * 0x165667B19E3779F9ull;
+        return hash;
+    }
+};
+
+struct ObjChunk
+{
+    const char *begin;
+    const char *end;
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners; //Three per triangle
+};
+
+static const char *skipSpaces(const char *c, const char *end)
+{
+    while (c < end && (*c == ' ' || *c == '\t'))
+    {
+        c++;
+    }
+    return c;
+}
+
+static const char *skipLine(const char *c, const char *end)
+{
+    while (c < end && *c != '\n')
+    {
+        c++;
+    }
+    return c < end ? c + 1 : end;
+}
+
+//strtod is locale dependent and a lot slower. Handles [+-]digits[.digits][(e|E)[+-]digits]
+static const char *parseNumber(const char *c, const char *end, double &value)
+{
+    static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                         1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    c = skipSpaces(c, end);
+    bool negative = false;
+    if (c < end && (*c == '-' || *c == '+'))
+    {
+        negative = *c == '-';
+        c++;
+    }
+
+    double result = 0.0;
+    while (c < end && *c >= '0' && *c <= '9')
+    {
+        result = result * 10.0 + (*c - '0');
+        c++;
+    }
+    if (c < end && *c == '.')
+    {
+        c++;
+        int32_t digits = 0;
+        double fraction = 0.0;
+        while (c < end && *c >= '0' && *c <= '9')
+        {
+            if (digits < 22)
+            {
+                fraction = fraction * 10.0 + (*c - '0');
+                digits++;
+            }
+            c++;
+        }
+        result += fraction / powersOfTen[digits];
+    }
+    if (c < end && (*c == 'e' || *c == 'E'))
+    {
+        c++;
+        bool negativeExponent = false;
+        if (c < end && (*c == '-' || *c == '+'))
+        {
+            negativeExponent = *c == '-';
+            c++;
+        }
+        int32_t exponent = 0;
+        while (c < end && *c >= '0' && *c <= '9')
+        {
+            exponent = std::min(exponent * 10 + (*c - '0'), 1000);
+            c++;
+        }
+        while (exponent > 0)
+        {
+            int32_t step = std::min(exponent, 22);
+            result = negativeExponent ? result / powersOfTen[step] : result * powersOfTen[step];
+            exponent -= step;
+        }
+    }
+    value = negative ? -result : result;
+    return c;
+}
+
+static const char *parseFloat(const char *c, const char *end, float &value)
+{
+    double number;
+    c = parseNumber(c, end, number);
+    value = float(number);
+    return c;
+}
+
+static const char *parseIndex(const char *c, const char *end, uint32_t countSoFar, int32_t &index)
+{
+    bool negative = false;
+    if (c < end && *c == '-')
+    {
+        negative = true;
+        c++;
+    }
+    int64_t value = 0;
+    bool hasDigits = false;
+    while (c < end && *c >= '0' && *c <= '9')
+    {
+        value = std::min<int64_t>(value * 10 + (*c - '0'), objRelativeBase);
+        hasDigits = true;
+        c++;
+    }
+
+    if (!hasDigits || value == 0)
+        index = objMissingIndex;
+    else if (negative)
+        index = int32_t(countSoFar) - int32_t(value) - objRelativeBase;
+    else
+        index = int32_t(value - 1);
+    return c;
+}
+
+static void parseObjChunk(ObjChunk &chunk)
+{
+    const char *c = chunk.begin;
+    const char *end = chunk.end;
+    std::vector<ObjCorner> polygon;
+    while (c < end)
+    {
+        c = skipSpaces(c, end);
+        if (end - c >= 2 && c[0] == 'v' && (c[1] == ' ' || c[1] == '\t'))
+        {
+            float position[3];
+            c = parseFloat(c + 2, end, position[0]);
+            c = parseFloat(c, end, position[1]);
+            c = parseFloat(c, end, position[2]);
+            chunk.positions.insert(chunk.positions.end(), position, position + 3);
+        }
+        else if (end - c >= 3 && c[0] == 'v' && c[1] == 't' && (c[2] == ' ' || c[2] == '\t'))
+        {
+            float uv[2];
+            c = parseFloat(c + 3, end, uv[0]);
+            c = parseFloat(c, end, uv[1]);
+            chunk.uvs.insert(chunk.uvs.end(), uv, uv + 2);
+        }
+        else if (end - c >= 3 && c[0] == 'v' && c[1] == 'n' && (c[2] == ' ' || c[2] == '\t'))
+        {
+            float normal[3];
+            c = parseFloat(c + 3, end, normal[0]);
+            c = parseFloat(c, end, normal[1]);
+            c = parseFloat(c, end, normal[2]);
+            chunk.normals.insert(chunk.normals.end(), normal, normal + 3);
+        }
+        else if (end - c >= 2 && c[0] == 'f' && (c[1] == ' ' || c[1] == '\t'))
+        {
+            polygon.clear();
+            c += 2;
+            while (true)
+            {
+                c = skipSpaces(c, end);
+                if (c >= end || *c == '\n' || *c == '\r' || *c == '#')
+                    break;
+
+                ObjCorner corner;
+                c = parseIndex(c, end, chunk.positions.size() / 3, corner.position);
+                corner.uv = objMissingIndex;
+                corner.normal = objMissingIndex;
+                if (c < end && *c == '/')
+                {
+                    c = parseIndex(c + 1, end, chunk.uvs.size() / 2, corner.uv);
+                    if (c < end && *c == '/')
+                        c = parseIndex(c + 1, end, chunk.normals.size() / 3, corner.normal);
+                }
+                if (corner.position == objMissingIndex)
+                    throw std::runtime_error("Face without position index in OBJ file");
+                polygon.push_back(corner);
+
+                //Anything else that is not a separator ends the face
+                if (c < end && *c != ' ' && *c != '\t' && *c != '\n' && *c != '\r')
+                    break;
+            }
+
+            for (size_t i = 2; i < polygon.size(); i++)
+            {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i - 1]);
+                chunk.corners.push_back(polygon[i]);
+            }
+        }
+        c = skipLine(c, end);
+    }
+}
+
+static int32_t resolveObjIndex(int32_t index, uint32_t chunkOffset, uint32_t count)
+{
+    if (index == objMissingIndex)
+        return objMissingIndex;
+    int64_t resolved = index < 0 ? int64_t(chunkOffset) + index + objRelativeBase : index;
+    if (resolved < 0 || resolved >= count)
+        throw std::runtime_error("Index out of range in OBJ file");
+    return int32_t(resolved);
+}
+
+void parseObj(const char *data, size_t size, MeshData &mesh, uint32_t amountOfWorkers)
+{
+    //Chunks end after a line end, so no line is split
+    uint32_t amountOfChunks = std::max<size_t>(1, std::min<size_t>(amountOfWorkers * 4, size / minObjChunkSize));
+    std::vector<ObjChunk> chunks(amountOfChunks);
+    const char *begin = data;
+    const char *end = data + size;
+    for (uint32_t i = 0; i < amountOfChunks; i++)
+    {
+        const char *chunkEnd = i + 1 == amountOfChunks ? end : skipLine(std::max(begin, data + size * (i + 1) / amountOfChunks), end);
+        chunks[i].begin = begin;
+        chunks[i].end = chunkEnd;
+        begin = chunkEnd;
+    }
+
+    if (amountOfChunks == 1 || amountOfWorkers <= 1)
+    {
+        for (auto &&chunk : chunks)
+        {
+            parseObjChunk(chunk);
+        }
+    }
+    else
+    {
+        TaskGraph parse;
+        for (auto &&chunk : chunks)
+        {
+            taskGraphAdd(parse, "objChunk", [&chunk]() { parseObjChunk(chunk); });
+        }
+        runTaskGraph(parse, std::min(amountOfWorkers, amountOfChunks) - 1);
+    }
+
+    //Concatenate the attributes, chunk offsets resolve the relative indices
+    std::vector<float> positions, uvs, normals;
+    std::vector<uint32_t> positionOffsets, uvOffsets, normalOffsets;
+    size_t amountOfCorners = 0;
+    for (auto &&chunk : chunks)
+    {
+        positionOffsets.push_back(positions.size() / 3);
+        uvOffsets.push_back(uvs.size() / 2);
+        normalOffsets.push_back(normals.size() / 3);
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        amountOfCorners += chunk.corners.size();
+    }
+    const uint32_t positionCount = positions.size() / 3;
+    const uint32_t uvCount = uvs.size() / 2;
+    const uint32_t normalCount = normals.size() / 3;
+
+    //Normals only count if every corner has one, otherwise they are computed later
+    bool hasNormals = normalCount > 0;
+    bool hasUvs = uvCount > 0;
+    for (auto &&chunk : chunks)
+    {
+        for (auto &&corner : chunk.corners)
+        {
+            hasNormals = hasNormals && corner.normal != objMissingIndex;
+        }
+    }
+
+    std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> vertices;
+    vertices.reserve(amountOfCorners / 4);
+    mesh = MeshData();
+    mesh.indices.reserve(amountOfCorners);
+    for (uint32_t c = 0; c < amountOfChunks; c++)
+    {
+        for (ObjCorner corner : chunks[c].corners)
+        {
+            corner.position = resolveObjIndex(corner.position, positionOffsets[c], positionCount);
+            corner.uv = hasUvs ? resolveObjIndex(corner.uv, uvOffsets[c], uvCount) : objMissingIndex;
+            corner.normal = hasNormals ? resolveObjIndex(corner.normal, normalOffsets[c], normalCount) : objMissingIndex;
+
+            auto inserted = vertices.insert({corner, getVertexCount(mesh)});
+            mesh.indices.push_back(inserted.first->second);
+            if (!inserted.second)
+                continue;
+
+            const float *position = &positions[corner.position * 3];
+            mesh.positions.insert(mesh.positions.end(), position, position + 3);
+            if (hasUvs)
+            {
+                const float missing[2] = {0.f, 0.f};
+                const float *uv = corner.uv == objMissingIndex ? missing : &uvs[corner.uv * 2];
+                mesh.uvs.insert(mesh.uvs.end(), uv, uv + 2);
+            }
+            if (hasNormals)
+            {
+                const float *normal = &normals[corner.normal * 3];
+                mesh.normals.insert(mesh.normals.end(), normal, normal + 3);
+            }
+        }
+    }
+}
+
+//glTF binary
+
+//Just enough JSON for the glTF header chunk
+struct JsonValue
+{
+    enum Type
+    {
+        JSON_NULL,
+        JSON_BOOL,
+        JSON_NUMBER,
+        JSON_STRING,
+        JSON_ARRAY,
+        JSON_OBJECT
+    };
+    Type type = JSON_NULL;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue *find(const char *key) const
+    {
+        for (auto &&member : object)
+        {
+            if (member.first == key)
+                return &member.second;
+        }
+        return NULL;
+    }
+
+    double numberOr(const char *key, double fallback) const
+    {
+        const JsonValue *value = find(key);
+        return value && value->type == JSON_NUMBER ? value->number : fallback;
+    }
+
+    //Counts, offsets and indices. Negative or missing values become fallback
+    uint32_t unsignedOr(const char *key, uint32_t fallback) const
+    {
+        double number = numberOr(key, -1.0);
+        return number >= 0.0 && number <= 4294967295.0 ? uint32_t(number) : fallback;
+    }
+};
+
+struct JsonParser
+{
+    const char *c;
+    const char *end;
+};
+
+static void jsonSkipSpaces(JsonParser &parser)
+{
+    while (parser.c < parser.end && (*parser.c == ' ' || *parser.c == '\t' || *parser.c == '\n' || *parser.c == '\r'))
+    {
+        parser.c++;
+    }
+}
+
+static void jsonExpect(JsonParser &parser, char expected)
+{
+    jsonSkipSpaces(parser);
+    if (parser.c >= parser.end || *parser.c != expected)
+        throw std::runtime_error("Malformed JSON in glTF file");
+    parser.c++;
+}
+
+//Escapes are kept as they are, glTF keys and the strings read here never need them
+static std::string jsonParseString(JsonParser &parser)
+{
+    jsonExpect(parser, '"');
+    const char *begin = parser.c;
+    while (parser.c < parser.end && *parser.c != '"')
+    {
+        if (*parser.c == '\\')
+            parser.c++;
+        parser.c++;
+    }
+    if (parser.c >= parser.end)
+        throw std::runtime_error("Malformed JSON in glTF file");
+    return std::string(begin, parser.c++);
+}
+
+static void jsonParseValue(JsonParser &parser, JsonValue &value, uint32_t depth)
+{
+    if (depth > 64)
+        throw std::runtime_error("JSON in glTF file nested too deep");
+    jsonSkipSpaces(parser);
+    if (parser.c >= parser.end)
+        throw std::runtime_error("Malformed JSON in glTF file");
+
+    char first = *parser.c;
+    if (first == '{')
+    {
+        value.type = JsonValue::JSON_OBJECT;
+        parser.c++;
+        jsonSkipSpaces(parser);
+        if (parser.c < parser.end && *parser.c == '}')
+        {
+            parser.c++;
+            return;
+        }
+        while (true)
+        {
+            value.object.emplace_back();
+            value.object.back().first = jsonParseString(parser);
+            jsonExpect(parser, ':');
+            jsonParseValue(parser, value.object.back().second, depth + 1);
+            jsonSkipSpaces(parser);
+            if (parser.c < parser.end && *parser.c == ',')
+            {
+                parser.c++;
+                continue;
+            }
+            jsonExpect(parser, '}');
+            return;
+        }
+    }
+    if (first == '[')
+    {
+        value.type = JsonValue::JSON_ARRAY;
+        parser.c++;
+        jsonSkipSpaces(parser);
+        if (parser.c < parser.end && *parser.c == ']')
+        {
+            parser.c++;
+            return;
+        }
+        while (true)
+        {
+            value.array.emplace_back();
+            jsonParseValue(parser, value.array.back(), depth + 1);
+            jsonSkipSpaces(parser);
+            if (parser.c < parser.end && *parser.c == ',')
+            {
+                parser.c++;
+                continue;
+            }
+            jsonExpect(parser, ']');
+            return;
+        }
+    }
+    if (first == '"')
+    {
+        value.type = JsonValue::JSON_STRING;
+        value.string = jsonParseString(parser);
+        return;
+    }
+    if (first == 't' || first == 'f' || first == 'n')
+    {
+        const char *word = first == 't' ? "true" : (first == 'f' ? "false" : "null");
+        size_t length = strlen(word);
+        if (size_t(parser.end - parser.c) < length || strncmp(parser.c, word, length) != 0)
+            throw std::runtime_error("Malformed JSON in glTF file");
+        value.type = first == 'n' ? JsonValue::JSON_NULL : JsonValue::JSON_BOOL;
+        value.number = first == 't' ? 1.0 : 0.0;
+        parser.c += length;
+        return;
+    }
+
+    value.type = JsonValue::JSON_NUMBER;
+    const char *begin = parser.c;
+    parser.c = parseNumber(parser.c, parser.end, value.number);
+    if (parser.c == begin)
+        throw std::runtime_error("Malformed JSON in glTF file");
+}
+
+const uint32_t glbMagic = 0x46546C67;     //"glTF"
+const uint32_t glbChunkJson = 0x4E4F534A; //"JSON"
+const uint32_t glbChunkBin = 0x004E4942;  //"BIN\0"
+const uint32_t gltfTriangles = 4;
+const uint32_t gltfUnsignedByte = 5121;
+const uint32_t gltfUnsignedShort = 5123;
+const uint32_t gltfUnsignedInt = 5125;
+const uint32_t gltfFloat = 5126;
+
+struct GltfAccessor
+{
+    const char *data;
+    uint32_t count;
+    uint32_t stride;
+    uint32_t componentType;
+    uint32_t components;
+    bool normalized;
+};
+
+struct GltfPrimitive
+{
+    GltfAccessor positions;
+    GltfAccessor normals;
+    GltfAccessor uvs;
+    GltfAccessor indices;
+};
+
+static uint32_t getComponentSize(uint32_t componentType)
+{
+    switch (componentType)
+    {
+    case gltfUnsignedByte:
+        return 1;
+    case gltfUnsignedShort:
+        return 2;
+    case gltfUnsignedInt:
+    case gltfFloat:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static uint32_t getComponentCount(const std::string &type)
+{
+    if (type == "SCALAR")
+        return 1;
+    if (type == "VEC2")
+        return 2;
+    if (type == "VEC3")
+        return 3;
+    if (type == "VEC4")
+        return 4;
+    return 0;
+}
+
+//Checks the whole accessor against the BIN chunk, so decoding needs no checks
+static GltfAccessor getAccessor(const JsonValue &root, uint32_t index, const char *bin, size_t binSize)
+{
+    const JsonValue *accessors = root.find("accessors");
+    const JsonValue *bufferViews = root.find("bufferViews");
+    if (!accessors || !bufferViews || index >= accessors->array.size())
+        throw std::runtime_error("Invalid accessor in glTF file");
+    const JsonValue &accessor = accessors->array[index];
+
+    uint32_t viewIndex = accessor.unsignedOr("bufferView", UINT32_MAX);
+    if (viewIndex >= bufferViews->array.size())
+        throw std::runtime_error("Accessor without buffer view in glTF file");
+    const JsonValue &view = bufferViews->array[viewIndex];
+    if (view.unsignedOr("buffer", 0) != 0)
+        throw std::runtime_error("Only the BIN chunk is supported as glTF buffer");
+
+    const JsonValue *type = accessor.find("type");
+    const JsonValue *normalized = accessor.find("normalized");
+    GltfAccessor result;
+    result.count = accessor.unsignedOr("count", 0);
+    result.componentType = accessor.unsignedOr("componentType", 0);
+    result.components = type ? getComponentCount(type->string) : 0;
+    result.normalized = normalized && normalized->number != 0.0;
+    uint32_t elementSize = getComponentSize(result.componentType) * result.components;
+    if (elementSize == 0)
+        throw std::runtime_error("Unsupported accessor type in glTF file");
+    result.stride = view.unsignedOr("byteStride", 0);
+    if (result.stride == 0)
+        result.stride = elementSize;
+
+    size_t offset = size_t(view.unsignedOr("byteOffset", 0)) + accessor.unsignedOr("byteOffset", 0);
+    size_t viewEnd = size_t(view.unsignedOr("byteOffset", 0)) + view.unsignedOr("byteLength", 0);
+    size_t accessorEnd = result.count == 0 ? offset : offset + size_t(result.count - 1) * result.stride + elementSize;
+    if (accessorEnd > viewEnd || viewEnd > binSize)
+        throw std::runtime_error("Accessor outside of the BIN chunk in glTF file");
+    result.data = bin + offset;
+    return result;
+}
+
+static float readComponent(const GltfAccessor &accessor, uint32_t element, uint32_t component)
+{
+    const char *data = accessor.data + size_t(element) * accessor.stride;
+    switch (accessor.componentType)
+    {
+    case gltfFloat:
+    {
+        float value;
+        memcpy(&value, data + component * 4, 4);
+        return value;
+    }
+    case gltfUnsignedShort:
+    {
+        uint16_t value;
+        memcpy(&value, data + component * 2, 2);
+        return accessor.normalized ? value / 65535.f : value;
+    }
+    case gltfUnsignedByte:
+    {
+        uint8_t value = data[component];
+        return accessor.normalized ? value / 255.f : value;
+    }
+    default:
+        return 0.f;
+    }
+}
+
+static uint32_t readIndex(const GltfAccessor &accessor, uint32_t element)
+{
+    const char *data = accessor.data + size_t(element) * accessor.stride;
+    switch (accessor.componentType)
+    {
+    case gltfUnsignedInt:
+    {
+        uint32_t value;
+        memcpy(&value, data, 4);
+        return value;
+    }
+    case gltfUnsignedShort:
+    {
+        uint16_t value;
+        memcpy(&value, data, 2);
+        return value;
+    }
+    case gltfUnsignedByte:
+        return uint8_t(data[0]);
+    default:
+        return UINT32_MAX;
+    }
+}
+
+static void decodeGltfPrimitive(const GltfPrimitive &primitive, MeshData &mesh)
+{
+    const uint32_t vertexCount = primitive.positions.count;
+    mesh.positions.resize(vertexCount * 3);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            mesh.positions[vertex * 3 + axis] = readComponent(primitive.positions, vertex, axis);
+        }
+    }
+    if (primitive.normals.data)
+    {
+        mesh.normals.resize(vertexCount * 3);
+        for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                mesh.normals[vertex * 3 + axis] = readComponent(primitive.normals, vertex, axis);
+            }
+        }
+    }
+    if (primitive.uvs.data)
+    {
+        mesh.uvs.resize(vertexCount * 2);
+        for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            mesh.uvs[vertex * 2] = readComponent(primitive.uvs, vertex, 0);
+            mesh.uvs[vertex * 2 + 1] = readComponent(primitive.uvs, vertex, 1);
+        }
+    }
+
+    if (primitive.indices.data)
+    {
+        mesh.indices.resize(primitive.indices.count);
+        for (uint32_t i = 0; i < primitive.indices.count; i++)
+        {
+            uint32_t index = readIndex(primitive.indices, i);
+            if (index >= vertexCount)
+                throw std::runtime_error("Index out of range in glTF file");
+            mesh.indices[i] = index;
+        }
+    }
+    else
+    {
+        mesh.indices.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            mesh.indices[i] = i;
+        }
+    }
+    mesh.indices.resize(mesh.indices.size() / 3 * 3);
+}
+
+void parseGlb(const char *data, size_t size, MeshData &mesh, uint32_t amountOfWorkers)
+{
+    uint32_t header[3];
+    if (size < sizeof(header))
+        throw std::runtime_error("glTF file too small");
+    memcpy(header, data, sizeof(header));
+    if (header[0] != glbMagic || header[1] != 2)
+        throw std::runtime_error("Not a binary glTF 2.0 file");
+    size = std::min<size_t>(size, header[2]);
+
+    const char *json = NULL;
+    const char *bin = NULL;
+    size_t jsonSize = 0;
+    size_t binSize = 0;
+    size_t offset = sizeof(header);
+    while (offset + 8 <= size)
+    {
+        uint32_t chunk[2];
+        memcpy(chunk, data + offset, sizeof(chunk));
+        offset += 8;
+        if (chunk[0] > size - offset)
+            throw std::runtime_error("Chunk outside of the glTF file");
+        if (chunk[1] == glbChunkJson && !json)
+        {
+            json = data + offset;
+            jsonSize = chunk[0];
+        }
+        else if (chunk[1] == glbChunkBin && !bin)
+        {
+            bin = data + offset;
+            binSize = chunk[0];
+        }
+        offset += (chunk[0] + 3) & ~3u;
+    }
+    if (!json)
+        throw std::runtime_error("glTF file without JSON chunk");
+
+    JsonValue root;
+    JsonParser parser = {json, json + jsonSize};
+    jsonParseValue(parser, root, 0);
+
+    std::vector<GltfPrimitive> primitives;
+    const JsonValue *meshes = root.find("meshes");
+    for (size_t m = 0; meshes && m < meshes->array.size(); m++)
+    {
+        const JsonValue *meshPrimitives = meshes->array[m].find("primitives");
+        for (size_t p = 0; meshPrimitives && p < meshPrimitives->array.size(); p++)
+        {
+            const JsonValue &primitive = meshPrimitives->array[p];
+            const JsonValue *attributes = primitive.find("attributes");
+            if (primitive.unsignedOr("mode", gltfTriangles) != gltfTriangles || !attributes || !attributes->find("POSITION"))
+                continue;
+
+            GltfPrimitive decoded;
+            memset(&decoded, 0, sizeof(decoded));
+            decoded.positions = getAccessor(root, attributes->unsignedOr("POSITION", UINT32_MAX), bin, binSize);
+            if (attributes->find("NORMAL"))
+                decoded.normals = getAccessor(root, attributes->unsignedOr("NORMAL", UINT32_MAX), bin, binSize);
+            if (attributes->find("TEXCOORD_0"))
+                decoded.uvs = getAccessor(root, attributes->unsignedOr("TEXCOORD_0", UINT32_MAX), bin, binSize);
+            if (primitive.find("indices"))
+                decoded.indices = getAccessor(root, primitive.unsignedOr("indices", UINT32_MAX), bin, binSize);
+
+            if (decoded.positions.components != 3 || (decoded.normals.data && decoded.normals.components != 3) ||
+                (decoded.uvs.data && decoded.uvs.components != 2) || (decoded.indices.data && decoded.indices.components != 1) ||
+                (decoded.normals.data && decoded.normals.count != decoded.positions.count) ||
+                (decoded.uvs.data && decoded.uvs.count != decoded.positions.count))
+                throw std::runtime_error("Unsupported primitive layout in glTF file");
+            primitives.push_back(decoded);
+        }
+    }
+
+    std::vector<MeshData> decoded(primitives.size());
+    if (primitives.size() <= 1 || amountOfWorkers <= 1)
+    {
+        for (size_t i = 0; i < primitives.size(); i++)
+        {
+            decodeGltfPrimitive(primitives[i], decoded[i]);
+        }
+    }
+    else
+    {
+        TaskGraph decode;
+        for (size_t i = 0; i < primitives.size(); i++)
+        {
+            taskGraphAdd(decode, "gltfPrimitive", [&primitives, &decoded, i]() { decodeGltfPrimitive(primitives[i], decoded[i]); });
+        }
+        runTaskGraph(decode, std::min<size_t>(amountOfWorkers, primitives.size()) - 1);
+    }
+
+    //A primitive without normals or uvs gets zeros if others have them, missing normals are computed later
+    bool hasNormals = !decoded.empty();
+    bool hasUvs = false;
+    for (auto &&primitive : decoded)
+    {
+        hasNormals = hasNormals && !primitive.normals.empty();
+        hasUvs = hasUvs || !primitive.uvs.empty();
+    }
+
+    mesh = MeshData();
+    for (auto &&primitive : decoded)
+    {
+        uint32_t firstVertex = getVertexCount(mesh);
+        mesh.positions.insert(mesh.positions.end(), primitive.positions.begin(), primitive.positions.end());
+        if (hasNormals)
+            mesh.normals.insert(mesh.normals.end(), primitive.normals.begin(), primitive.normals.end());
+        if (hasUvs)
+        {
+            if (primitive.uvs.empty())
+                mesh.uvs.resize(mesh.uvs.size() + getVertexCount(primitive) * 2, 0.f);
+            else
+                mesh.uvs.insert(mesh.uvs.end(), primitive.uvs.begin(), primitive.uvs.end());
+        }
+        for (uint32_t index : primitive.indices)
+        {
+            mesh.indices.push_back(firstVertex + index);
+        }
+    }
+}
+
+static bool hasExtension(const std::string &filename, const char *extension)
+{
+    size_t length = strlen(extension);
+    if (filename.size() < length)
+        return false;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (tolower(filename[filename.size() - length + i]) != extension[i])
+            return false;
+    }
+    return true;
+}
+
+void loadMesh(const std::string &filename, MeshData &mesh, uint32_t amountOfWorkers)
+{
+    MappedFile file = mapFile(filename);
+    try
+    {
+        if (hasExtension(filename, ".obj"))
+        {
+            parseObj(file.data, file.size, mesh, amountOfWorkers);
+        }
+        else if (hasExtension(filename, ".glb"))
+        {
+            parseGlb(file.data, file.size, mesh, amountOfWorkers);
+            //OBJ corners are merged while parsing
+            deduplicateVertices(mesh);
+        }
+        else
+        {
+            throw std::runtime_error("Unknown mesh format " + filename);
+        }
+    }
+    catch (...)
+    {
+        unmapFile(file);
+        throw;
+    }
+    unmapFile(file);
+
+    if (mesh.normals.empty())
+        computeNormals(mesh);
+    optimizeVertexCache(mesh.indices, getVertexCount(mesh));
+    optimizeVertexFetch(mesh);
+}
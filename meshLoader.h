@@ -0,0 +1,29 @@
+#pragma once
+#include "mesh.h"
+#include <cstddef>
+#include <string>
+
+//Read only mapping of a whole file
+struct MappedFile
+{
+    const char *data = NULL;
+    size_t size = 0;
+};
+
+//All functions below throw std::runtime_error if the file can not be read or is malformed. The parsers rethrow
+//on the calling thread when a worker hits the error
+MappedFile mapFile(const std::string &filename);
+void unmapFile(MappedFile &file);
+
+//Parses an OBJ in amountOfWorkers chunks split at line ends. Faces are triangulated as fans, corners with the
+//same position, uv and normal index become one vertex
+void parseObj(const char *data, size_t size, MeshData &mesh, uint32_t amountOfWorkers);
+
+//Triangle primitives of all meshes in a binary glTF, in mesh space (node transforms are not applied).
+//Primitives are decoded in parallel
+void parseGlb(const char *data, size_t size, MeshData &mesh, uint32_t amountOfWorkers);
+
+//Maps the file, picks the parser by the extension (.obj or .glb) and prepares the result for drawing:
+//duplicate vertices merged, missing normals computed, triangles ordered for the vertex cache and vertices
+//ordered by first use
+void loadMesh(const std::string &filename, MeshData &mesh, uint32_t amountOfWorkers);
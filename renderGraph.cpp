@@ -0,0 +1,528 @@
+#include "renderGraph.h"
+#include "vulkanHelper.h"
+#include <algorithm>
+
+struct UsageInfo
+{
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    VkImageLayout layout;
+    VkImageUsageFlags imageUsage;
+    bool write;
+};
+
+static UsageInfo getUsageInfo(RenderGraphUsage usage)
+{
+    switch (usage)
+    {
+    case RG_USAGE_COLOR_ATTACHMENT_WRITE:
+        return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true};
+    case RG_USAGE_DEPTH_ATTACHMENT_WRITE:
+        return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true};
+    case RG_USAGE_DEPTH_ATTACHMENT_READ:
+        return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false};
+    case RG_USAGE_SAMPLED_READ:
+        return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false};
+    case RG_USAGE_STORAGE_READ:
+        return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false};
+    case RG_USAGE_STORAGE_WRITE:
+        return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true};
+    case RG_USAGE_TRANSFER_SRC:
+        return {VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false};
+    case RG_USAGE_TRANSFER_DST:
+    default:
+        return {VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true};
+    }
+}
+
+//Synchronisation state of one resource while walking the passes
+struct ResourceState
+{
+    VkImageLayout layout;
+    VkPipelineStageFlags writeStages; //Stages of the last write (or layout transition)
+    VkAccessFlags writeAccess;
+    VkPipelineStageFlags readStages; //Stages that already saw the last write
+    int firstBarrierPass;
+    int firstBarrierIndex;
+};
+
+uint32_t renderGraphImportImage(RenderGraph &graph, const char *name, VkImageAspectFlags aspect,
+                                VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags initialStage,
+                                VkAccessFlags initialAccess)
+{
+    RenderGraphResource resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.aspect = aspect;
+    resource.initialLayout = initialLayout;
+    resource.finalLayout = finalLayout;
+    resource.initialStage = initialStage;
+    resource.initialAccess = initialAccess;
+    graph.resources.push_back(resource);
+    return graph.resources.size() - 1;
+}
+
+void renderGraphSetImportedImage(RenderGraph &graph, uint32_t resource, VkImage image, VkImageView view)
+{
+    graph.resources[resource].image = image;
+    graph.resources[resource].view = view;
+}
+
+uint32_t renderGraphCreateImage(RenderGraph &graph, const char *name, VkFormat format, VkExtent2D extent,
+                                VkImageAspectFlags aspect, uint32_t mipLevels)
+{
+    RenderGraphResource resource;
+    resource.name = name;
+    resource.format = format;
+    resource.extent = extent;
+    resource.aspect = aspect;
+    resource.mipLevels = mipLevels;
+    graph.resources.push_back(resource);
+    return graph.resources.size() - 1;
+}
+
+void renderGraphAddPass(RenderGraph &graph, const char *name, const std::vector<RenderGraphAccess> &accesses,
+                        RenderGraphExecute execute, bool sideEffects)
+{
+    RenderGraphPass pass;
+    pass.name = name;
+    pass.accesses = accesses;
+    pass.execute = execute;
+    pass.sideEffects = sideEffects;
+    graph.passes.push_back(pass);
+}
+
+void renderGraphMarkOutput(RenderGraph &graph, uint32_t resource)
+{
+    graph.outputs.push_back(resource);
+}
+
+VkImage renderGraphGetImage(const RenderGraph &graph, uint32_t resource)
+{
+    return graph.resources[resource].image;
+}
+
+VkImageView renderGraphGetImageView(const RenderGraph &graph, uint32_t resource)
+{
+    return graph.resources[resource].view;
+}
+
+//Walk the passes backwards and keep only those which contribute to an output
+static void cullPasses(RenderGraph &graph)
+{
+    std::vector<bool> needed(graph.resources.size(), false);
+    for (uint32_t output : graph.outputs)
+    {
+        needed[output] = true;
+    }
+
+    for (int p = (int)graph.passes.size() - 1; p >= 0; p--)
+    {
+        RenderGraphPass &pass = graph.passes[p];
+        bool alive = pass.sideEffects;
+        for (auto &&access : pass.accesses)
+        {
+            if (getUsageInfo(access.usage).write && needed[access.resource])
+                alive = true;
+        }
+        pass.culled = !alive;
+        if (!alive)
+            continue;
+
+        for (auto &&access : pass.accesses)
+        {
+            if (!getUsageInfo(access.usage).write)
+                needed[access.resource] = true;
+        }
+    }
+}
+
+static VkImageMemoryBarrier makeBarrier(const RenderGraphResource &resource, VkImageLayout oldLayout, VkImageLayout newLayout,
+                                        VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = VK_NULL_HANDLE;
+    barrier.subresourceRange.aspectMask = resource.aspect;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    return barrier;
+}
+
+//Computes the minimal set of barriers between the alive passes. Reads of the same layout
+//share one barrier, write after read only needs an execution dependency
+static std::vector<ResourceState> placeBarriers(RenderGraph &graph)
+{
+    std::vector<ResourceState> states(graph.resources.size());
+    for (size_t r = 0; r < graph.resources.size(); r++)
+    {
+        RenderGraphResource &resource = graph.resources[r];
+        states[r].layout = resource.imported ? resource.initialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+        states[r].writeStages = resource.imported ? resource.initialStage : 0;
+        states[r].writeAccess = resource.imported ? resource.initialAccess : 0;
+        states[r].readStages = 0;
+        states[r].firstBarrierPass = -1;
+        states[r].firstBarrierIndex = -1;
+        resource.firstPass = -1;
+        resource.lastPass = -1;
+        resource.usage = 0;
+    }
+
+    for (size_t p = 0; p < graph.passes.size(); p++)
+    {
+        RenderGraphPass &pass = graph.passes[p];
+        pass.barriers.clear();
+        pass.barrierResources.clear();
+        pass.srcStageMask = 0;
+        pass.dstStageMask = 0;
+        if (pass.culled)
+            continue;
+
+        for (auto &&access : pass.accesses)
+        {
+            RenderGraphResource &resource = graph.resources[access.resource];
+            ResourceState &state = states[access.resource];
+            UsageInfo info = getUsageInfo(access.usage);
+
+            bool firstUse = resource.firstPass < 0;
+            if (firstUse)
+                resource.firstPass = p;
+            resource.lastPass = p;
+            resource.usage |= info.imageUsage;
+
+            bool layoutChange = state.layout != info.layout;
+            bool needBarrier;
+            if (firstUse)
+                needBarrier = true;
+            else if (info.write)
+                needBarrier = true;
+            else
+                needBarrier = layoutChange || (state.writeAccess != 0 && (state.readStages & info.stage) != info.stage);
+
+            if (!needBarrier)
+            {
+                state.readStages |= info.stage;
+                continue;
+            }
+
+            VkPipelineStageFlags srcStages = state.writeStages;
+            if (info.write || layoutChange)
+                srcStages |= state.readStages;
+
+            if (firstUse && !resource.imported)
+            {
+                //Filled in by patchFirstBarriers, the previous contents are never needed
+                state.firstBarrierPass = p;
+                state.firstBarrierIndex = pass.barriers.size();
+                pass.barriers.push_back(makeBarrier(resource, VK_IMAGE_LAYOUT_UNDEFINED, info.layout, 0, info.access));
+            }
+            else
+            {
+                pass.barriers.push_back(makeBarrier(resource, state.layout, info.layout, state.writeAccess, info.access));
+                pass.srcStageMask |= srcStages;
+            }
+            pass.barrierResources.push_back(access.resource);
+            pass.dstStageMask |= info.stage;
+
+            state.layout = info.layout;
+            if (info.write || layoutChange)
+            {
+                state.writeStages = info.stage;
+                state.writeAccess = info.write ? (info.access & ~(VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                                                  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                                                  VK_ACCESS_SHADER_READ_BIT))
+                                               : info.access;
+                state.readStages = info.write ? 0 : info.stage;
+            }
+            else
+            {
+                state.readStages |= info.stage;
+            }
+        }
+    }
+
+    graph.finalBarriers.clear();
+    graph.finalBarrierResources.clear();
+    graph.finalSrcStageMask = 0;
+    for (size_t r = 0; r < graph.resources.size(); r++)
+    {
+        RenderGraphResource &resource = graph.resources[r];
+        if (!resource.imported || resource.firstPass < 0 || states[r].layout == resource.finalLayout)
+            continue;
+        graph.finalBarriers.push_back(makeBarrier(resource, states[r].layout, resource.finalLayout, states[r].writeAccess, 0));
+        graph.finalBarrierResources.push_back(r);
+        graph.finalSrcStageMask |= states[r].writeStages | states[r].readStages;
+    }
+
+    return states;
+}
+
+static bool lifetimesOverlap(const RenderGraphResource &a, const RenderGraphResource &b)
+{
+    return !(a.lastPass < b.firstPass || b.lastPass < a.firstPass);
+}
+
+//Images whose memory block was used before by another image have to wait for that image's last use.
+//The first occupant waits for the last one of the previous execution of the graph
+static void patchFirstBarriers(RenderGraph &graph, const std::vector<ResourceState> &states)
+{
+    for (auto &&block : graph.memoryBlocks)
+    {
+        for (size_t i = 0; i < block.occupants.size(); i++)
+        {
+            uint32_t current = block.occupants[i];
+            uint32_t previous = block.occupants[(i + block.occupants.size() - 1) % block.occupants.size()];
+            const ResourceState &state = states[current];
+            const ResourceState &previousState = states[previous];
+
+            RenderGraphPass &pass = graph.passes[state.firstBarrierPass];
+            VkImageMemoryBarrier &barrier = pass.barriers[state.firstBarrierIndex];
+            barrier.srcAccessMask = previousState.writeAccess;
+            pass.srcStageMask |= previousState.writeStages | previousState.readStages;
+        }
+    }
+}
+
+static void allocateTransientImages(RenderGraph &graph, VkPhysicalDevice physicalDevice, VkDevice device)
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    bool hasLazyMemory = findMemoryTypeIndex(memoryProperties, ~0u, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) >= 0;
+
+    const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                              VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                                              VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+    std::vector<uint32_t> transients;
+    std::vector<VkMemoryRequirements> requirements(graph.resources.size());
+    for (size_t r = 0; r < graph.resources.size(); r++)
+    {
+        RenderGraphResource &resource = graph.resources[r];
+        if (resource.imported || resource.firstPass < 0)
+            continue;
+
+        //Attachment-only images of a single pass never leave tile memory and can live in lazily allocated memory.
+        //A later pass loading the image needs it stored, which commits the memory anyway
+        resource.lazy = hasLazyMemory && (resource.usage & ~attachmentUsage) == 0 && resource.firstPass == resource.lastPass;
+
+        VkImageCreateInfo imageCreateInfo;
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.pNext = NULL;
+        imageCreateInfo.flags = 0;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = resource.format;
+        imageCreateInfo.extent = {resource.extent.width, resource.extent.height, 1};
+        imageCreateInfo.mipLevels = resource.mipLevels;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = resource.usage | (resource.lazy ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.queueFamilyIndexCount = 0;
+        imageCreateInfo.pQueueFamilyIndices = NULL;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkResult result = vkCreateImage(device, &imageCreateInfo, NULL, &resource.image);
+        ASSERT_VULKAN(result);
+        vkGetImageMemoryRequirements(device, resource.image, &requirements[r]);
+        transients.push_back(r);
+    }
+
+    //Biggest images first, so smaller ones can slot into the blocks they already opened
+    std::stable_sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b) {
+        return requirements[a].size > requirements[b].size;
+    });
+
+    VkDeviceSize unaliasedSize = 0;
+    for (uint32_t r : transients)
+    {
+        RenderGraphResource &resource = graph.resources[r];
+        unaliasedSize += requirements[r].size;
+
+        int chosen = -1;
+        for (size_t b = 0; b < graph.memoryBlocks.size() && chosen < 0; b++)
+        {
+            RenderGraphMemoryBlock &block = graph.memoryBlocks[b];
+            if (block.lazy != resource.lazy || (block.memoryTypeBits & requirements[r].memoryTypeBits) == 0)
+                continue;
+            bool fits = true;
+            for (uint32_t occupant : block.occupants)
+            {
+                if (lifetimesOverlap(resource, graph.resources[occupant]))
+                    fits = false;
+            }
+            if (fits)
+                chosen = b;
+        }
+        if (chosen < 0)
+        {
+            graph.memoryBlocks.push_back(RenderGraphMemoryBlock());
+            graph.memoryBlocks.back().lazy = resource.lazy;
+            chosen = graph.memoryBlocks.size() - 1;
+        }
+
+        RenderGraphMemoryBlock &block = graph.memoryBlocks[chosen];
+        block.size = std::max(block.size, requirements[r].size);
+        block.memoryTypeBits &= requirements[r].memoryTypeBits;
+        block.occupants.push_back(r);
+        resource.memoryBlock = chosen;
+    }
+
+    for (auto &&block : graph.memoryBlocks)
+    {
+        //Occupants in execution order, used to chain the aliasing barriers
+        std::sort(block.occupants.begin(), block.occupants.end(), [&](uint32_t a, uint32_t b) {
+            return graph.resources[a].firstPass < graph.resources[b].firstPass;
+        });
+
+        int memoryTypeIndex = -1;
+        if (block.lazy)
+            memoryTypeIndex = findMemoryTypeIndex(memoryProperties, block.memoryTypeBits,
+                                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+        if (memoryTypeIndex < 0)
+            memoryTypeIndex = findMemoryTypeIndex(memoryProperties, block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (memoryTypeIndex < 0)
+            memoryTypeIndex = findMemoryTypeIndex(memoryProperties, block.memoryTypeBits, 0);
+
+        VkMemoryAllocateInfo memoryAllocateInfo;
+        memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        memoryAllocateInfo.pNext = NULL;
+        memoryAllocateInfo.allocationSize = block.size;
+        memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkResult result = vkAllocateMemory(device, &memoryAllocateInfo, NULL, &block.memory);
+        ASSERT_VULKAN(result);
+
+        for (uint32_t occupant : block.occupants)
+        {
+            result = vkBindImageMemory(device, graph.resources[occupant].image, block.memory, 0);
+            ASSERT_VULKAN(result);
+        }
+    }
+
+    for (uint32_t r : transients)
+    {
+        RenderGraphResource &resource = graph.resources[r];
+
+        VkImageViewCreateInfo imageViewCreateInfo;
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.pNext = NULL;
+        imageViewCreateInfo.flags = 0;
+        imageViewCreateInfo.image = resource.image;
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = resource.format;
+        imageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.subresourceRange.aspectMask = resource.aspect;
+        imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+        imageViewCreateInfo.subresourceRange.levelCount = resource.mipLevels;
+        imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+        imageViewCreateInfo.subresourceRange.layerCount = 1;
+
+        VkResult result = vkCreateImageView(device, &imageViewCreateInfo, NULL, &resource.view);
+        ASSERT_VULKAN(result);
+    }
+    graph.unaliasedMemorySize = unaliasedSize;
+}
+
+void compileRenderGraph(RenderGraph &graph, VkPhysicalDevice physicalDevice, VkDevice device)
+{
+    cullPasses(graph);
+    std::vector<ResourceState> states = placeBarriers(graph);
+    allocateTransientImages(graph, physicalDevice, device);
+    patchFirstBarriers(graph, states);
+}
+
+void printRenderGraphStats(const RenderGraph &graph, std::ostream &out)
+{
+    size_t culledPasses = 0, barrierCount = graph.finalBarriers.size();
+    for (auto &&pass : graph.passes)
+    {
+        culledPasses += pass.culled ? 1 : 0;
+        barrierCount += pass.barriers.size();
+    }
+    VkDeviceSize aliasedSize = 0;
+    for (auto &&block : graph.memoryBlocks)
+    {
+        aliasedSize += block.size;
+    }
+    out << "Render graph: " << graph.passes.size() << " passes (" << culledPasses << " culled), "
+        << barrierCount << " image barriers\n";
+    out << "Render graph transient memory: " << aliasedSize << " bytes in " << graph.memoryBlocks.size()
+        << " blocks (" << graph.unaliasedMemorySize << " bytes without aliasing)\n";
+}
+
+static void recordBarriers(RenderGraph &graph, std::vector<VkImageMemoryBarrier> &barriers, const std::vector<uint32_t> &barrierResources,
+                           VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
+{
+    if (barriers.empty())
+        return;
+
+    for (size_t i = 0; i < barriers.size(); i++)
+    {
+        barriers[i].image = graph.resources[barrierResources[i]].image;
+    }
+    if (srcStageMask == 0)
+        srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    if (dstStageMask == 0)
+        dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, NULL, 0, NULL, barriers.size(), barriers.data());
+}
+
+void recordRenderGraph(RenderGraph &graph, VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    for (auto &&pass : graph.passes)
+    {
+        if (pass.culled)
+            continue;
+        recordBarriers(graph, pass.barriers, pass.barrierResources, commandBuffer, pass.srcStageMask, pass.dstStageMask);
+        pass.execute(commandBuffer, imageIndex);
+    }
+    recordBarriers(graph, graph.finalBarriers, graph.finalBarrierResources, commandBuffer, graph.finalSrcStageMask, 0);
+}
+
+void destroyRenderGraph(RenderGraph &graph, VkDevice device)
+{
+    for (auto &&resource : graph.resources)
+    {
+        if (resource.imported)
+            continue;
+        if (resource.view != VK_NULL_HANDLE)
+            vkDestroyImageView(device, resource.view, NULL);
+        if (resource.image != VK_NULL_HANDLE)
+            vkDestroyImage(device, resource.image, NULL);
+    }
+    for (auto &&block : graph.memoryBlocks)
+    {
+        vkFreeMemory(device, block.memory, NULL);
+    }
+    graph = RenderGraph();
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//How a pass touches a resource. Every usage maps to a stage, an access mask and an image layout
+enum RenderGraphUsage
+{
+    RG_USAGE_COLOR_ATTACHMENT_WRITE,
+    RG_USAGE_DEPTH_ATTACHMENT_WRITE,
+    RG_USAGE_DEPTH_ATTACHMENT_READ,
+    RG_USAGE_SAMPLED_READ,
+    RG_USAGE_STORAGE_READ,
+    RG_USAGE_STORAGE_WRITE,
+    RG_USAGE_TRANSFER_SRC,
+    RG_USAGE_TRANSFER_DST
+};
+
+struct RenderGraphAccess
+{
+    uint32_t resource;
+    RenderGraphUsage usage;
+};
+
+typedef std::function<void(VkCommandBuffer commandBuffer, uint32_t imageIndex)> RenderGraphExecute;
+
+struct RenderGraphResource
+{
+    std::string name;
+    bool imported = false;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent = {0, 0};
+    VkImageAspectFlags aspect = 0;
+    uint32_t mipLevels = 1;
+    VkImageUsageFlags usage = 0; //Derived from the declared accesses
+    VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags initialStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    VkAccessFlags initialAccess = 0;
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+
+    //Filled in by compileRenderGraph
+    int firstPass = -1;
+    int lastPass = -1;
+    bool lazy = false;
+    int memoryBlock = -1;
+};
+
+struct RenderGraphPass
+{
+    std::string name;
+    std::vector<RenderGraphAccess> accesses;
+    RenderGraphExecute execute;
+    bool sideEffects = false;
+    bool culled = false;
+
+    //Barriers placed in front of the pass, the image handle is patched in while recording
+    std::vector<VkImageMemoryBarrier> barriers;
+    std::vector<uint32_t> barrierResources;
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+};
+
+struct RenderGraphMemoryBlock
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    uint32_t memoryTypeBits = ~0u;
+    bool lazy = false;
+    std::vector<uint32_t> occupants;
+};
+
+struct RenderGraph
+{
+    std::vector<RenderGraphResource> resources;
+    std::vector<RenderGraphPass> passes;
+    std::vector<uint32_t> outputs;
+    std::vector<RenderGraphMemoryBlock> memoryBlocks;
+    VkDeviceSize unaliasedMemorySize = 0; //What the transient images would take up without aliasing
+
+    //Transitions of imported resources into their final layout after the last pass
+    std::vector<VkImageMemoryBarrier> finalBarriers;
+    std::vector<uint32_t> finalBarrierResources;
+    VkPipelineStageFlags finalSrcStageMask = 0;
+};
+
+//Resources owned outside of the graph, e.g. swapchain images. The handles can change every frame.
+//initialAccess are the writes before the graph the first use has to see, e.g. of the previous frame
+uint32_t renderGraphImportImage(RenderGraph &graph, const char *name, VkImageAspectFlags aspect,
+                                VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags initialStage,
+                                VkAccessFlags initialAccess = 0);
+void renderGraphSetImportedImage(RenderGraph &graph, uint32_t resource, VkImage image, VkImageView view);
+
+//Transient images only live inside one execution of the graph and may share memory with each other
+uint32_t renderGraphCreateImage(RenderGraph &graph, const char *name, VkFormat format, VkExtent2D extent,
+                                VkImageAspectFlags aspect, uint32_t mipLevels = 1);
+
+void renderGraphAddPass(RenderGraph &graph, const char *name, const std::vector<RenderGraphAccess> &accesses,
+                        RenderGraphExecute execute, bool sideEffects = false);
+void renderGraphMarkOutput(RenderGraph &graph, uint32_t resource);
+
+VkImage renderGraphGetImage(const RenderGraph &graph, uint32_t resource);
+VkImageView renderGraphGetImageView(const RenderGraph &graph, uint32_t resource);
+
+//Culls unused passes, places barriers and allocates the transient images
+void compileRenderGraph(RenderGraph &graph, VkPhysicalDevice physicalDevice, VkDevice device);
+void recordRenderGraph(RenderGraph &graph, VkCommandBuffer commandBuffer, uint32_t imageIndex);
+void destroyRenderGraph(RenderGraph &graph, VkDevice device);
+//Passes, barriers and transient memory of the last compile. Compiling prints nothing, it runs on every resize
+void printRenderGraphStats(const RenderGraph &graph, std::ostream &out);
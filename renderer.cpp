@@ -0,0 +1,2751 @@
+//#include <vulkan/vulkan.h>
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <fstream>
+#include <limits>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include "renderer.h"
+#include "vulkanHelper.h"
+#include "renderGraph.h"
+#include "drawList.h"
+#include "spscQueue.h"
+#include "tripleBuffer.h"
+#include "taskGraph.h"
+#include "scene.h"
+#include "lod.h"
+#include "meshLoader.h"
+
+enum WindowEventType
+{
+    WINDOW_EVENT_RESIZE,
+    WINDOW_EVENT_CURSOR
+};
+
+//Sent from the GLFW callbacks on the main thread to the render thread
+struct WindowEvent
+{
+    WindowEventType type;
+    int width;
+    int height;
+    double x;
+    double y;
+};
+
+//Written by the main thread once per simulation step, the render thread draws the newest one
+struct SimulationState
+{
+    double time = 0.0;
+};
+
+VkInstance instance;
+VkSurfaceKHR surface;
+VkPhysicalDevice physicalDevice;
+VkDevice device;
+VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+VkShaderModule shaderModuleVert;
+VkShaderModule shaderModuleFrag;
+std::vector<char> shaderCodeVert;
+std::vector<char> shaderCodeFrag;
+std::vector<VkImage> swapchainImages;
+std::vector<VkDeviceMemory> headlessImageMemory;
+std::vector<VkImageView> imageViews;
+std::vector<VkFramebuffer> framebuffers;
+VkFramebuffer depthPrepassFramebuffer;
+GLFWwindow *window;
+VkPipelineLayout pipelineLayout;
+VkRenderPass renderPass;
+VkRenderPass depthPrepassRenderPass;
+VkPipeline pipeline;
+VkPipeline depthPrepassPipeline;
+std::vector<VkPipeline> pipelineTable;
+VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+VkCommandPool commandPool;
+std::vector<VkCommandBuffer> commandBuffers;
+std::vector<VkFence> commandBufferFences;
+VkSemaphore semaphoreImageAvailable;
+VkSemaphore semaphoreRenderingDone;
+VkQueue queue;
+RenderGraph renderGraph;
+uint32_t backbufferResource;
+uint32_t depthResource;
+uint32_t sceneColorResource;
+VkPipelineStageFlags backbufferWaitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+DrawList drawList;
+FrameTimings lastFrameTimings;
+
+uint32_t amountOfImagesInSwapchain = 0;
+uint32_t width = 400, height = 300;
+const VkFormat ourFormat = VK_FORMAT_B8G8R8A8_SRGB;
+VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+bool headless = false;
+bool useValidationLayers = true;
+bool printDiagnostics = false;
+bool useDepthPrepass = true;
+bool useDynamicResolution = false;
+bool useOcclusionCulling = false;
+DynamicResolution dynamicResolution;
+VkExtent2D renderExtent = {400, 300}; //Scene resolution of the frame being recorded
+uint32_t sceneDrawCount = 64;
+float lodPixelError = 1.f;
+const float lodHysteresis = 0.25f;
+const uint32_t amountOfHeadlessImages = 3;
+uint32_t headlessFrame = 0;
+
+//GPU time of the scene passes, two timestamps per swapchain image
+VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+std::vector<bool> timestampsWritten;
+std::vector<float> frameRenderScales;
+double timestampPeriod = 1.0;
+uint64_t timestampMask = ~0ull;
+
+//Device dumps are collected here and written in one go after the first frame, see reportStartup
+std::ostringstream diagnosticLog;
+std::chrono::steady_clock::time_point startupStart;
+
+SpscQueue<WindowEvent, 256> windowEvents;
+std::vector<WindowEvent> overflowWindowEvents; //Main thread only, keeps the order when the queue is full
+TripleBuffer<SimulationState> simulationSnapshots;
+std::atomic<bool> renderThreadRunning(false);
+const double simulationStep = 1.0 / 240.0;
+
+//Render thread only
+SimulationState simulationState;
+float cursorOffset[2] = {0.f, 0.f};
+
+//Root, one row node per eight draws and one leaf per draw. Render thread only
+SceneStore scene;
+uint32_t sceneRoot;
+std::vector<uint32_t> sceneRows;
+std::vector<uint32_t> sceneLeaves;
+std::vector<uint32_t> sceneLeafLods; //Level of detail each leaf was drawn with in the last frame
+float sceneRootOffset[2] = {0.f, 0.f};
+
+//World matrices of the scene, one host visible buffer per swapchain image. A buffer only gets the matrices
+//which changed since it was written the last time
+std::vector<VkBuffer> transformBuffers;
+std::vector<VkDeviceMemory> transformBufferMemory;
+std::vector<Matrix4 *> transformBufferData;
+std::vector<uint32_t> transformBufferVersions;
+uint32_t transformBufferCapacity = 0;
+
+//Every draw uses this mesh, either loaded from meshFilename or the built in triangle
+const char *meshFilename = NULL;
+Mesh sceneMesh;
+VkBuffer meshVertexBuffer;
+VkDeviceMemory meshVertexBufferMemory;
+VkBuffer meshIndexBuffer;
+VkDeviceMemory meshIndexBufferMemory;
+
+//Undoes the position quantization of the mesh in the vertex shader, see shader.vert
+struct MeshPushConstants
+{
+    float positionScale[4];
+    float positionOffset[4];
+};
+MeshPushConstants meshPushConstants;
+float meshLodScale = 1.f; //Turns the errors of sceneMesh.lods into draw space, the fit of loadSceneMesh
+
+//Occlusion culling. The early phase draws what survives the depth pyramid of the last frame, the pyramid is then
+//built from that depth and the late phase draws what the early phase culled but is visible after all
+VkShaderModule shaderModuleDepthPyramid;
+VkShaderModule shaderModuleOcclusionCull;
+std::vector<char> shaderCodeDepthPyramid;
+std::vector<char> shaderCodeOcclusionCull;
+VkDescriptorSetLayout depthPyramidSetLayout;
+VkPipelineLayout depthPyramidPipelineLayout;
+VkPipeline depthPyramidPipeline;
+VkDescriptorSetLayout cullSetLayout;
+VkPipelineLayout cullPipelineLayout;
+VkPipeline cullPipeline;
+VkSampler depthPyramidSampler;
+VkRenderPass lateRenderPass;
+VkPipeline latePipeline;
+std::vector<VkPipeline> latePipelineTable;
+uint32_t maxDrawIndirectCount = 1; //1 without multiDrawIndirect
+
+//Farthest depth of every two by two block of the level below, level 0 halves the depth buffer. Lives as long as
+//the render graph but is imported, so its contents carry over into the next frame
+VkImage depthPyramidImage;
+VkDeviceMemory depthPyramidMemory;
+VkImageView depthPyramidView; //All levels, read by the cull shader
+std::vector<VkImageView> depthPyramidLevelViews;
+VkDescriptorPool depthPyramidDescriptorPool;
+std::vector<VkDescriptorSet> depthPyramidDescriptorSets; //One per level
+VkExtent2D depthPyramidExtent;
+uint32_t depthPyramidLevels = 0;
+uint32_t depthPyramidResource;
+bool depthPyramidInitialized = false; //Moved out of the undefined layout
+bool depthPyramidBuilt = false;
+VkExtent2D depthPyramidViewport; //renderExtent of the frame that built the pyramid
+
+//One per draw in sorted order, see occlusionCull.comp
+struct CullDraw
+{
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t transform;
+};
+
+struct CullPushConstants
+{
+    float boxCenter[4];
+    float boxExtent[4];
+    float viewport[2];
+    uint32_t drawCount;
+    uint32_t late;
+    uint32_t pyramidLevels;
+};
+
+//Per swapchain image the draws for the cull shader and the indirect commands it writes, the early ones followed
+//by the late ones. Host visible, so the culled draws can be counted once the fence was waited on
+std::vector<VkBuffer> cullDrawBuffers;
+std::vector<VkDeviceMemory> cullDrawBufferMemory;
+std::vector<CullDraw *> cullDrawBufferData;
+std::vector<VkBuffer> indirectBuffers;
+std::vector<VkDeviceMemory> indirectBufferMemory;
+std::vector<VkDrawIndexedIndirectCommand *> indirectBufferData;
+std::vector<uint32_t> indirectDrawCounts; //Draws of the frame that used the buffer the last time
+uint32_t cullBufferCapacity = 0;
+VkDescriptorPool cullDescriptorPool;
+std::vector<VkDescriptorSet> cullDescriptorSets;
+int requestedWidth = 0, requestedHeight = 0;
+bool windowMinimized = false;
+bool swapchainOutOfDate = false;
+
+//Print some stats about the graphics card
+void printStats(const VkPhysicalDevice &device)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    uint32_t apiVer = properties.apiVersion;
+
+    diagnosticLog << "Name:                     " << properties.deviceName << '\n'
+                  << "API Version:              " << VK_VERSION_MAJOR(apiVer) << '.' << VK_VERSION_MINOR(apiVer) << '.' << VK_VERSION_PATCH(apiVer) << '\n'
+                  << "Driver Version:           " << properties.driverVersion << '\n'
+                  << "Vendor ID:                " << properties.vendorID << '\n'
+                  << "Device ID:                " << properties.deviceID << '\n'
+                  << "Device Type:              " << properties.deviceType << '\n'
+                  << "DiscreteQueuePriorities:  " << properties.limits.discreteQueuePriorities << '\n';
+
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(device, &features);
+    diagnosticLog << "Geometry Shader:          " << features.geometryShader << '\n';
+
+    VkPhysicalDeviceMemoryProperties memProp;
+    vkGetPhysicalDeviceMemoryProperties(device, &memProp);
+
+    uint32_t amountOfQueueFamilies = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &amountOfQueueFamilies, NULL);
+    VkQueueFamilyProperties *familyProperties = new VkQueueFamilyProperties[amountOfQueueFamilies];
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &amountOfQueueFamilies, familyProperties);
+
+    diagnosticLog << "Amount of Queue Families: " << amountOfQueueFamilies << '\n';
+
+    for (int i = 0; i < amountOfQueueFamilies; i++)
+    {
+        diagnosticLog << '\n';
+        diagnosticLog << "Queue Familie #" << i << '\n';
+        diagnosticLog << "VK_QUEUE_GRAPHICS_BIT         " << ((familyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) ? "true" : "false") << '\n';
+        diagnosticLog << "VK_QUEUE_COMPUTE_BIT          " << ((familyProperties[i].queueFlags & VK_QUEUE_COMPUTE_BIT) ? "true" : "false") << '\n';
+        diagnosticLog << "VK_QUEUE_TRANSFER_BIT         " << ((familyProperties[i].queueFlags & VK_QUEUE_TRANSFER_BIT) ? "true" : "false") << '\n';
+        diagnosticLog << "VK_QUEUE_SPARSE_BINDING_BIT   " << ((familyProperties[i].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) ? "true" : "false") << '\n';
+        diagnosticLog << "Queue Count: " << familyProperties[i].queueCount << '\n';
+        diagnosticLog << "Timestamp valid Bits: " << familyProperties[i].timestampValidBits << '\n';
+        uint32_t width = familyProperties[i].minImageTransferGranularity.width;
+        uint32_t height = familyProperties[i].minImageTransferGranularity.height;
+        uint32_t depth = familyProperties[i].minImageTransferGranularity.depth;
+        diagnosticLog << "Min image Timestamp Grabularity: " << width << ", " << height << ", " << depth << '\n';
+    }
+
+    delete[] familyProperties;
+
+    //Headless there is no surface
+    if (headless)
+        return;
+
+    VkSurfaceCapabilitiesKHR surfaceCapabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &surfaceCapabilities);
+
+    diagnosticLog << "\tSurface capabilities:         " << '\n';
+    diagnosticLog << "\tMin Image Count:              " << surfaceCapabilities.minImageCount << '\n';
+    diagnosticLog << "\tMax Image Count:              " << surfaceCapabilities.maxImageCount << '\n';
+    diagnosticLog << "\tCurrent Extent:               " << surfaceCapabilities.currentExtent.width << '/' << surfaceCapabilities.currentExtent.height << '\n';
+    diagnosticLog << "\tMin Image Extent:             " << surfaceCapabilities.minImageExtent.width << '/' << surfaceCapabilities.minImageExtent.height << '\n';
+    diagnosticLog << "\tMax Image Extent:             " << surfaceCapabilities.maxImageExtent.width << '/' << surfaceCapabilities.maxImageExtent.height << '\n';
+    diagnosticLog << "\tMax Image Array Layers:       " << surfaceCapabilities.maxImageArrayLayers << '\n';
+    diagnosticLog << "\tSupported Transforms:         " << surfaceCapabilities.supportedTransforms << '\n';
+    diagnosticLog << "\tCurrent Transforms:           " << surfaceCapabilities.currentTransform << '\n';
+    diagnosticLog << "\tSupported Composite Alpha:    " << surfaceCapabilities.supportedCompositeAlpha << '\n';
+    diagnosticLog << "\tSupported Usage Flags:        " << surfaceCapabilities.supportedUsageFlags << '\n';
+
+    uint32_t amountOfFormats = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &amountOfFormats, NULL);
+    std::vector<VkSurfaceFormatKHR> surfaceFormats;
+    surfaceFormats.resize(amountOfFormats);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &amountOfFormats, surfaceFormats.data());
+
+    diagnosticLog << '\n';
+    diagnosticLog << "Amount of Formats: " << amountOfFormats << '\n';
+    for (auto &&i : surfaceFormats)
+    {
+        diagnosticLog << "Formats: " << i.format << '\n';
+        diagnosticLog << "Color Space: " << i.colorSpace << '\n';
+    }
+
+    uint32_t amountOfPresentationModes = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &amountOfPresentationModes, NULL);
+    std::vector<VkPresentModeKHR> presentModes;
+    presentModes.resize(amountOfPresentationModes);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &amountOfPresentationModes, presentModes.data());
+
+    diagnosticLog << '\n';
+    diagnosticLog << "Amount of Presentation Modes: " << amountOfPresentationModes << '\n';
+    for (auto &&i : presentModes)
+    {
+        diagnosticLog << "Supported presentation mode: " << i << '\n';
+    }
+
+    diagnosticLog << '\n';
+}
+
+std::vector<char> readFile(const std::string &&filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open file");
+    }
+    size_t fileSize = (size_t)file.tellg();
+    std::vector<char> fileBuffer(fileSize);
+    file.seekg(0);
+    file.read(fileBuffer.data(), fileSize);
+    return fileBuffer;
+}
+
+void recreateSwapchain();
+
+std::vector<VkPhysicalDevice> getAllPhysicalDevices();
+
+void postWindowEvent(const WindowEvent &event)
+{
+    if (!overflowWindowEvents.empty() || !spscQueuePush(windowEvents, event))
+        overflowWindowEvents.push_back(event);
+}
+
+void flushWindowEvents()
+{
+    size_t sent = 0;
+    while (sent < overflowWindowEvents.size() && spscQueuePush(windowEvents, overflowWindowEvents[sent]))
+    {
+        sent++;
+    }
+    overflowWindowEvents.erase(overflowWindowEvents.begin(), overflowWindowEvents.begin() + sent);
+}
+
+//GLFW callbacks run on the main thread and only pass the events on, the render thread does the work
+void onWindowResized(GLFWwindow *window, int w, int h)
+{
+    WindowEvent event = {};
+    event.type = WINDOW_EVENT_RESIZE;
+    event.width = w;
+    event.height = h;
+    postWindowEvent(event);
+}
+
+void onCursorMoved(GLFWwindow *window, double x, double y)
+{
+    WindowEvent event = {};
+    event.type = WINDOW_EVENT_CURSOR;
+    event.x = x;
+    event.y = y;
+    postWindowEvent(event);
+}
+
+//Only initializes GLFW, the window is created by startVulkan while the Vulkan setup runs on other threads
+void startGLFW()
+{
+    startupStart = std::chrono::steady_clock::now();
+    glfwInit();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    //glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+}
+
+void createWindow()
+{
+    window = glfwCreateWindow(width, height, "Vulkan Tutorial", NULL, NULL);
+    glfwSetWindowSizeCallback(window, onWindowResized);
+    glfwSetCursorPosCallback(window, onCursorMoved);
+}
+
+void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule)
+{
+    VkShaderModuleCreateInfo shaderCreateInfo;
+    shaderCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderCreateInfo.pNext = NULL;
+    shaderCreateInfo.flags = 0;
+    shaderCreateInfo.codeSize = code.size();
+    shaderCreateInfo.pCode = (uint32_t *)code.data();
+
+    VkResult result = vkCreateShaderModule(device, &shaderCreateInfo, NULL, shaderModule);
+    ASSERT_VULKAN(result);
+}
+
+void createInstance()
+{
+    //Create application info
+    VkApplicationInfo appInfo;
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pNext = NULL;
+    appInfo.pApplicationName = "Vulkan Tutorial";
+    appInfo.applicationVersion = VK_MAKE_VERSION(0, 0, 0);
+    appInfo.pEngineName = "Engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(0, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+
+    std::vector<const char *> validationLayers;
+    if (useValidationLayers)
+        validationLayers.push_back("VK_LAYER_KHRONOS_validation");
+
+    //Without a window there is no surface and no extension is needed
+    uint32_t amountOfGlfwExtensions = 0;
+    const char **glfwExtension = NULL;
+    if (!headless)
+        glfwExtension = glfwGetRequiredInstanceExtensions(&amountOfGlfwExtensions);
+
+    //Create instance info
+    VkInstanceCreateInfo instanceInfo;
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pNext = NULL;
+    instanceInfo.flags = 0;
+    instanceInfo.pApplicationInfo = &appInfo;
+    instanceInfo.enabledLayerCount = validationLayers.size();
+    instanceInfo.ppEnabledLayerNames = validationLayers.data();
+    instanceInfo.enabledExtensionCount = amountOfGlfwExtensions;
+    instanceInfo.ppEnabledExtensionNames = glfwExtension;
+
+    //Create instance
+    VkResult result = vkCreateInstance(&instanceInfo, NULL, &instance);
+    ASSERT_VULKAN(result);
+}
+
+void printInstanceLayers()
+{
+    std::vector<VkLayerProperties> layers;
+    uint32_t amountOfLayers = 0;
+    vkEnumerateInstanceLayerProperties(&amountOfLayers, NULL);
+    layers.resize(amountOfLayers);
+    vkEnumerateInstanceLayerProperties(&amountOfLayers, layers.data());
+
+    diagnosticLog << "Amount of layers: " << amountOfLayers << '\n';
+    for (int i = 0; i < amountOfLayers; i++)
+    {
+        diagnosticLog << "Layer: " << i << '\n';
+        diagnosticLog << "\tName:         " << layers[i].layerName << '\n';
+        diagnosticLog << "\tSpec version: " << layers[i].specVersion << '\n';
+        diagnosticLog << "\tImpl Version: " << layers[i].implementationVersion << '\n';
+        diagnosticLog << "\tDescription:  " << layers[i].description << '\n';
+        diagnosticLog << '\n';
+    }
+}
+
+void printInstanceExtensions()
+{
+    uint32_t amountOfExtensions = 0;
+    vkEnumerateInstanceExtensionProperties(NULL, &amountOfExtensions, NULL);
+    std::vector<VkExtensionProperties> extensions;
+    extensions.resize(amountOfExtensions);
+    vkEnumerateInstanceExtensionProperties(NULL, &amountOfExtensions, extensions.data());
+
+    diagnosticLog << '\n';
+    diagnosticLog << "Amount of Extensions: " << amountOfExtensions << '\n';
+    for (int i = 0; i < amountOfExtensions; i++)
+    {
+        diagnosticLog << '\n';
+        diagnosticLog << "Name: " << extensions[i].extensionName << '\n';
+        diagnosticLog << "Spec Version: " << extensions[i].specVersion << '\n';
+    }
+    diagnosticLog << '\n';
+}
+
+void createGlfwWindowSurface()
+{
+    VkResult result;
+    result = glfwCreateWindowSurface(instance, window, NULL, &surface);
+    ASSERT_VULKAN(result);
+}
+
+std::vector<VkPhysicalDevice> getAllPhysicalDevices()
+{
+    VkResult result;
+    uint32_t amountOfPhysicalDevices = 0;
+    result = vkEnumeratePhysicalDevices(instance, &amountOfPhysicalDevices, NULL);
+    ASSERT_VULKAN(result);
+
+    std::vector<VkPhysicalDevice> physicalDevices;
+    physicalDevices.resize(amountOfPhysicalDevices);
+
+    result = vkEnumeratePhysicalDevices(instance, &amountOfPhysicalDevices, physicalDevices.data());
+
+    ASSERT_VULKAN(result);
+
+    return physicalDevices;
+}
+
+void printStatsOfAllPhysicalDevices()
+{
+    auto physicalDevices = getAllPhysicalDevices();
+
+    for (size_t i = 0; i < physicalDevices.size(); i++)
+    {
+        printStats(physicalDevices[i]);
+    }
+}
+
+//TODO pick "best device" instead of first device
+void pickPhysicalDevice()
+{
+    physicalDevice = getAllPhysicalDevices()[0];
+}
+
+void createLogicalDevice()
+{
+    VkResult result;
+    float queuePrios[] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    //Create device queue info
+    VkDeviceQueueCreateInfo deviceQueueCreateInfo;
+    deviceQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    deviceQueueCreateInfo.pNext = NULL;
+    deviceQueueCreateInfo.flags = 0;
+    deviceQueueCreateInfo.queueFamilyIndex = 0; //TODO Choose correct family index
+    deviceQueueCreateInfo.queueCount = 1;       //TODO Check if this amount is valid
+    deviceQueueCreateInfo.pQueuePriorities = queuePrios;
+
+    VkPhysicalDeviceFeatures usedFeatures = {};
+    if (useOcclusionCulling)
+    {
+        //The cull shader passes the transform of a draw on as its first instance
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        if (!supportedFeatures.drawIndirectFirstInstance)
+            throw std::runtime_error("Occlusion culling needs drawIndirectFirstInstance");
+        usedFeatures.drawIndirectFirstInstance = VK_TRUE;
+        usedFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        maxDrawIndirectCount = supportedFeatures.multiDrawIndirect ? properties.limits.maxDrawIndirectCount : 1;
+    }
+
+    std::vector<const char *> deviceExtensions;
+    if (!headless)
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    //Create device info
+    VkDeviceCreateInfo devicesCreateInfo;
+    devicesCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    devicesCreateInfo.pNext = NULL;
+    devicesCreateInfo.flags = 0;
+    devicesCreateInfo.queueCreateInfoCount = 1;
+    devicesCreateInfo.pQueueCreateInfos = &deviceQueueCreateInfo;
+    devicesCreateInfo.enabledLayerCount = 0;
+    devicesCreateInfo.ppEnabledLayerNames = NULL;
+    devicesCreateInfo.enabledExtensionCount = deviceExtensions.size();
+    devicesCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    devicesCreateInfo.pEnabledFeatures = &usedFeatures;
+
+    //Craete device
+    result = vkCreateDevice(physicalDevice, &devicesCreateInfo, NULL, &device);
+    ASSERT_VULKAN(result);
+}
+
+void createQueue()
+{
+    vkGetDeviceQueue(device, 0, 0, &queue);
+}
+
+void checkSurfaceSupport()
+{
+    VkResult result;
+    VkBool32 surfaceSupport = false;
+    result = vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, 0, surface, &surfaceSupport);
+    ASSERT_VULKAN(result)
+}
+
+//Stand-in for the swapchain when running without a window, the images are rendered to but never presented
+void createHeadlessImages()
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    amountOfImagesInSwapchain = amountOfHeadlessImages;
+    swapchainImages.resize(amountOfImagesInSwapchain);
+    headlessImageMemory.resize(amountOfImagesInSwapchain);
+    for (uint32_t i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        VkImageCreateInfo imageCreateInfo;
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.pNext = NULL;
+        imageCreateInfo.flags = 0;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = ourFormat;
+        imageCreateInfo.extent = {width, height, 1};
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.queueFamilyIndexCount = 0;
+        imageCreateInfo.pQueueFamilyIndices = NULL;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkResult result = vkCreateImage(device, &imageCreateInfo, NULL, &swapchainImages[i]);
+        ASSERT_VULKAN(result);
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(device, swapchainImages[i], &memoryRequirements);
+        int memoryTypeIndex = findMemoryTypeIndex(memoryProperties, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (memoryTypeIndex < 0)
+            memoryTypeIndex = findMemoryTypeIndex(memoryProperties, memoryRequirements.memoryTypeBits, 0);
+
+        VkMemoryAllocateInfo memoryAllocateInfo;
+        memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        memoryAllocateInfo.pNext = NULL;
+        memoryAllocateInfo.allocationSize = memoryRequirements.size;
+        memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+        result = vkAllocateMemory(device, &memoryAllocateInfo, NULL, &headlessImageMemory[i]);
+        ASSERT_VULKAN(result);
+        result = vkBindImageMemory(device, swapchainImages[i], headlessImageMemory[i], 0);
+        ASSERT_VULKAN(result);
+    }
+}
+
+void destroyHeadlessImages()
+{
+    for (uint32_t i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        vkDestroyImage(device, swapchainImages[i], NULL);
+        vkFreeMemory(device, headlessImageMemory[i], NULL);
+    }
+    headlessImageMemory.clear();
+}
+
+void createSwapchain()
+{
+    if (headless)
+    {
+        createHeadlessImages();
+        return;
+    }
+
+    VkSwapchainCreateInfoKHR swapchainCreateInfo;
+    swapchainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    swapchainCreateInfo.pNext = NULL;
+    swapchainCreateInfo.flags = 0;
+    swapchainCreateInfo.surface = surface;
+    swapchainCreateInfo.minImageCount = 2;                                   //TODO Check if valid
+    swapchainCreateInfo.imageFormat = ourFormat;                             //TODO civ
+    swapchainCreateInfo.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR; //TODO civ
+    swapchainCreateInfo.imageExtent = {width, height};
+    swapchainCreateInfo.imageArrayLayers = 1;
+    //With dynamic resolution the scene is blitted into the swapchain image
+    swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (useDynamicResolution)
+        swapchainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE; //TODO civ
+    swapchainCreateInfo.queueFamilyIndexCount = 0;
+    swapchainCreateInfo.pQueueFamilyIndices = NULL;
+    swapchainCreateInfo.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    swapchainCreateInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR; //TODO civ
+    swapchainCreateInfo.clipped = VK_TRUE;
+    swapchainCreateInfo.oldSwapchain = swapchain;
+
+    //Creatinf the Swapchain
+    VkResult result = vkCreateSwapchainKHR(device, &swapchainCreateInfo, NULL, &swapchain);
+    ASSERT_VULKAN(result);
+}
+
+void createImageViews()
+{
+    VkResult result;
+    if (!headless)
+    {
+        vkGetSwapchainImagesKHR(device, swapchain, &amountOfImagesInSwapchain, NULL);
+        swapchainImages.resize(amountOfImagesInSwapchain);
+        result = vkGetSwapchainImagesKHR(device, swapchain, &amountOfImagesInSwapchain, swapchainImages.data());
+        ASSERT_VULKAN(result);
+    }
+
+    imageViews.resize(amountOfImagesInSwapchain);
+    for (int i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        //Create image view info
+        VkImageViewCreateInfo imageViewCreateInfo;
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.pNext = NULL;
+        imageViewCreateInfo.flags = 0;
+        imageViewCreateInfo.image = swapchainImages[i];
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = ourFormat; //TODO civ
+        imageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+        imageViewCreateInfo.subresourceRange.levelCount = 1;
+        imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+        imageViewCreateInfo.subresourceRange.layerCount = 1;
+
+        result = vkCreateImageView(device, &imageViewCreateInfo, NULL, &imageViews.data()[i]);
+        ASSERT_VULKAN(result);
+    }
+}
+
+//The depth pyramid is built by sampling the depth buffer
+VkFormat findDepthFormat()
+{
+    const VkFormat candidates[] = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM};
+    VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if (useOcclusionCulling)
+        features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    for (VkFormat format : candidates)
+    {
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+        if ((formatProperties.optimalTilingFeatures & features) == features)
+            return format;
+    }
+    return VK_FORMAT_D16_UNORM;
+}
+
+void createRenderPass()
+{
+    depthFormat = findDepthFormat();
+
+    VkAttachmentDescription attachmentDescriptions[2];
+    attachmentDescriptions[0].flags = 0;
+    attachmentDescriptions[0].format = ourFormat;
+    attachmentDescriptions[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachmentDescriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachmentDescriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachmentDescriptions[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachmentDescriptions[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    //Layout transitions are placed by the render graph
+    attachmentDescriptions[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachmentDescriptions[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    //With a depth prepass the main pass only tests against the finished depth buffer
+    VkImageLayout depthLayout = useDepthPrepass ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                                                : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    attachmentDescriptions[1].flags = 0;
+    attachmentDescriptions[1].format = depthFormat;
+    attachmentDescriptions[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachmentDescriptions[1].loadOp = useDepthPrepass ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+    //The depth pyramids and the late pass of occlusion culling still need it, the late pass keeps this store
+    attachmentDescriptions[1].storeOp = useOcclusionCulling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachmentDescriptions[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachmentDescriptions[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachmentDescriptions[1].initialLayout = depthLayout;
+    attachmentDescriptions[1].finalLayout = depthLayout;
+
+    VkAttachmentReference attachmentReference;
+    attachmentReference.attachment = 0;
+    attachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthAttachmentReference;
+    depthAttachmentReference.attachment = 1;
+    depthAttachmentReference.layout = depthLayout;
+
+    VkSubpassDescription subpassDescription;
+    subpassDescription.flags = 0;
+    subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpassDescription.inputAttachmentCount = 0;
+    subpassDescription.pInputAttachments = NULL;
+    subpassDescription.colorAttachmentCount = 1;
+    subpassDescription.pColorAttachments = &attachmentReference;
+    subpassDescription.pResolveAttachments = NULL;
+    subpassDescription.pDepthStencilAttachment = &depthAttachmentReference;
+    subpassDescription.preserveAttachmentCount = 0;
+    subpassDescription.pPreserveAttachments = NULL;
+
+    VkRenderPassCreateInfo renderPassCreateInfo;
+    renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassCreateInfo.pNext = NULL;
+    renderPassCreateInfo.flags = 0;
+    renderPassCreateInfo.attachmentCount = 2;
+    renderPassCreateInfo.pAttachments = attachmentDescriptions;
+    renderPassCreateInfo.subpassCount = 1;
+    renderPassCreateInfo.pSubpasses = &subpassDescription;
+    renderPassCreateInfo.dependencyCount = 0;
+    renderPassCreateInfo.pDependencies = NULL;
+
+    VkResult result = vkCreateRenderPass(device, &renderPassCreateInfo, NULL, &renderPass);
+    ASSERT_VULKAN(result);
+
+    if (useOcclusionCulling)
+    {
+        //Draws the late phase on top of the early one, compatible with renderPass so it shares the framebuffers
+        VkAttachmentDescription lateAttachments[2] = {attachmentDescriptions[0], attachmentDescriptions[1]};
+        lateAttachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        lateAttachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        lateAttachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        lateAttachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference lateDepthReference;
+        lateDepthReference.attachment = 1;
+        lateDepthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription lateSubpass = subpassDescription;
+        lateSubpass.pDepthStencilAttachment = &lateDepthReference;
+
+        VkRenderPassCreateInfo lateRenderPassCreateInfo = renderPassCreateInfo;
+        lateRenderPassCreateInfo.pAttachments = lateAttachments;
+        lateRenderPassCreateInfo.pSubpasses = &lateSubpass;
+
+        result = vkCreateRenderPass(device, &lateRenderPassCreateInfo, NULL, &lateRenderPass);
+        ASSERT_VULKAN(result);
+    }
+
+    if (!useDepthPrepass)
+        return;
+
+    //Depth only pass, fills the depth buffer so the main pass shades every pixel once
+    VkAttachmentDescription depthPrepassAttachment = attachmentDescriptions[1];
+    depthPrepassAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthPrepassAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    depthPrepassAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthPrepassAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthPrepassReference;
+    depthPrepassReference.attachment = 0;
+    depthPrepassReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription depthPrepassSubpass = subpassDescription;
+    depthPrepassSubpass.colorAttachmentCount = 0;
+    depthPrepassSubpass.pColorAttachments = NULL;
+    depthPrepassSubpass.pDepthStencilAttachment = &depthPrepassReference;
+
+    renderPassCreateInfo.attachmentCount = 1;
+    renderPassCreateInfo.pAttachments = &depthPrepassAttachment;
+    renderPassCreateInfo.pSubpasses = &depthPrepassSubpass;
+
+    result = vkCreateRenderPass(device, &renderPassCreateInfo, NULL, &depthPrepassRenderPass);
+    ASSERT_VULKAN(result);
+}
+
+//Depth only pipelines skip the fragment shader and have no color attachment
+VkPipeline createGraphicsPipeline(VkRenderPass pass, bool depthOnly, VkCompareOp depthCompareOp, VkBool32 depthWriteEnable)
+{
+    VkPipelineShaderStageCreateInfo shaderStageCreateInfoVert;
+    shaderStageCreateInfoVert.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageCreateInfoVert.pNext = NULL;
+    shaderStageCreateInfoVert.flags = 0;
+    shaderStageCreateInfoVert.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStageCreateInfoVert.module = shaderModuleVert;
+    shaderStageCreateInfoVert.pName = "main";
+    shaderStageCreateInfoVert.pSpecializationInfo = NULL;
+
+    VkPipelineShaderStageCreateInfo shaderStageCreateInfoFrag;
+    shaderStageCreateInfoFrag.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageCreateInfoFrag.pNext = NULL;
+    shaderStageCreateInfoFrag.flags = 0;
+    shaderStageCreateInfoFrag.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStageCreateInfoFrag.module = shaderModuleFrag;
+    shaderStageCreateInfoFrag.pName = "main";
+    shaderStageCreateInfoFrag.pSpecializationInfo = NULL;
+
+    VkPipelineShaderStageCreateInfo shaderStages[] = {shaderStageCreateInfoVert,
+                                                      shaderStageCreateInfoFrag};
+
+    //The world matrix of every draw comes from the transform buffer, one per instance
+    VkVertexInputBindingDescription transformBinding;
+    transformBinding.binding = 0;
+    transformBinding.stride = sizeof(Matrix4);
+    transformBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VkVertexInputAttributeDescription transformAttributes[4];
+    for (uint32_t column = 0; column < 4; column++)
+    {
+        transformAttributes[column].location = column;
+        transformAttributes[column].binding = 0;
+        transformAttributes[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        transformAttributes[column].offset = column * 4 * sizeof(float);
+    }
+
+    //The mesh vertices are QuantizedVertex, the formats do the decoding
+    VkVertexInputBindingDescription meshBinding;
+    meshBinding.binding = 1;
+    meshBinding.stride = sizeof(QuantizedVertex);
+    meshBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription meshAttributes[3];
+    meshAttributes[0].location = 4;
+    meshAttributes[0].binding = 1;
+    meshAttributes[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+    meshAttributes[0].offset = offsetof(QuantizedVertex, position);
+    meshAttributes[1].location = 5;
+    meshAttributes[1].binding = 1;
+    meshAttributes[1].format = VK_FORMAT_R16G16_SNORM;
+    meshAttributes[1].offset = offsetof(QuantizedVertex, normal);
+    meshAttributes[2].location = 6;
+    meshAttributes[2].binding = 1;
+    meshAttributes[2].format = VK_FORMAT_R16G16_SFLOAT;
+    meshAttributes[2].offset = offsetof(QuantizedVertex, uv);
+
+    VkVertexInputBindingDescription bindings[] = {transformBinding, meshBinding};
+    VkVertexInputAttributeDescription attributes[] = {transformAttributes[0], transformAttributes[1], transformAttributes[2], transformAttributes[3],
+                                                      meshAttributes[0], meshAttributes[1], meshAttributes[2]};
+
+    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo;
+    vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputCreateInfo.pNext = NULL;
+    vertexInputCreateInfo.flags = 0;
+    vertexInputCreateInfo.vertexBindingDescriptionCount = 2;
+    vertexInputCreateInfo.pVertexBindingDescriptions = bindings;
+    vertexInputCreateInfo.vertexAttributeDescriptionCount = 7;
+    vertexInputCreateInfo.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo;
+    inputAssemblyCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssemblyCreateInfo.pNext = NULL;
+    inputAssemblyCreateInfo.flags = 0;
+    inputAssemblyCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssemblyCreateInfo.primitiveRestartEnable = VK_FALSE;
+
+    //Create a viewport state with a viewport and scissor, both are set while recording (see setViewport)
+    //since the scene resolution can change every frame
+    VkPipelineViewportStateCreateInfo viewportStateCreateInfo;
+    viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportStateCreateInfo.pNext = NULL;
+    viewportStateCreateInfo.flags = 0;
+    viewportStateCreateInfo.viewportCount = 1;
+    viewportStateCreateInfo.pViewports = NULL;
+    viewportStateCreateInfo.scissorCount = 1;
+    viewportStateCreateInfo.pScissors = NULL;
+
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo;
+    dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateCreateInfo.pNext = NULL;
+    dynamicStateCreateInfo.flags = 0;
+    dynamicStateCreateInfo.dynamicStateCount = 2;
+    dynamicStateCreateInfo.pDynamicStates = dynamicStates;
+
+    //Create a Rasterizater state
+    VkPipelineRasterizationStateCreateInfo rasterizationCreateInfo;
+    rasterizationCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizationCreateInfo.pNext = NULL;
+    rasterizationCreateInfo.flags = 0;
+    rasterizationCreateInfo.depthClampEnable = VK_FALSE;
+    rasterizationCreateInfo.rasterizerDiscardEnable = VK_FALSE;
+    rasterizationCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizationCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizationCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterizationCreateInfo.depthBiasEnable = VK_FALSE;
+    rasterizationCreateInfo.depthBiasConstantFactor = 0.f;
+    rasterizationCreateInfo.depthBiasClamp = 0.f;
+    rasterizationCreateInfo.depthBiasSlopeFactor = 0.f;
+    rasterizationCreateInfo.lineWidth = 1.f;
+
+    //Create a Multisampler state
+    VkPipelineMultisampleStateCreateInfo multisampleCreateInfo;
+    multisampleCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampleCreateInfo.pNext = NULL;
+    multisampleCreateInfo.flags = 0;
+    multisampleCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampleCreateInfo.sampleShadingEnable = VK_FALSE;
+    multisampleCreateInfo.minSampleShading = 1.f;
+    multisampleCreateInfo.pSampleMask = NULL;
+    multisampleCreateInfo.alphaToCoverageEnable = VK_FALSE;
+    multisampleCreateInfo.alphaToOneEnable = VK_FALSE;
+
+    //Create a depth stencil state
+    VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo;
+    depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilCreateInfo.pNext = NULL;
+    depthStencilCreateInfo.flags = 0;
+    depthStencilCreateInfo.depthTestEnable = VK_TRUE;
+    depthStencilCreateInfo.depthWriteEnable = depthWriteEnable;
+    depthStencilCreateInfo.depthCompareOp = depthCompareOp;
+    depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
+    depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
+    depthStencilCreateInfo.front = {};
+    depthStencilCreateInfo.back = {};
+    depthStencilCreateInfo.minDepthBounds = 0.f;
+    depthStencilCreateInfo.maxDepthBounds = 1.f;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment;
+    colorBlendAttachment.blendEnable = VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo;
+    colorBlendCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlendCreateInfo.pNext = NULL;
+    colorBlendCreateInfo.flags = 0;
+    colorBlendCreateInfo.logicOpEnable = VK_FALSE;
+    colorBlendCreateInfo.logicOp = VK_LOGIC_OP_NO_OP;
+    colorBlendCreateInfo.attachmentCount = depthOnly ? 0 : 1;
+    colorBlendCreateInfo.pAttachments = depthOnly ? NULL : &colorBlendAttachment;
+    colorBlendCreateInfo.blendConstants[0] = 0.f;
+    colorBlendCreateInfo.blendConstants[1] = 0.f;
+    colorBlendCreateInfo.blendConstants[2] = 0.f;
+    colorBlendCreateInfo.blendConstants[3] = 0.f;
+
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo;
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.pNext = NULL;
+    pipelineCreateInfo.flags = 0;
+    pipelineCreateInfo.stageCount = depthOnly ? 1 : 2;
+    pipelineCreateInfo.pStages = shaderStages;
+    pipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;
+    pipelineCreateInfo.pInputAssemblyState = &inputAssemblyCreateInfo;
+    pipelineCreateInfo.pTessellationState = NULL;
+    pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
+    pipelineCreateInfo.pRasterizationState = &rasterizationCreateInfo;
+    pipelineCreateInfo.pMultisampleState = &multisampleCreateInfo;
+    pipelineCreateInfo.pDepthStencilState = &depthStencilCreateInfo;
+    pipelineCreateInfo.pColorBlendState = &colorBlendCreateInfo;
+    pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
+    pipelineCreateInfo.layout = pipelineLayout;
+    pipelineCreateInfo.renderPass = pass;
+    pipelineCreateInfo.subpass = 0;
+    pipelineCreateInfo.basePipelineHandle = NULL;
+    pipelineCreateInfo.basePipelineIndex = -1;
+
+    VkPipeline graphicsPipeline;
+    VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, NULL, &graphicsPipeline);
+    ASSERT_VULKAN(result);
+    return graphicsPipeline;
+}
+
+//Pipelines are created again on every resize, the cache makes that cheap
+void createPipelineCache()
+{
+    VkPipelineCacheCreateInfo pipelineCacheCreateInfo;
+    pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipelineCacheCreateInfo.pNext = NULL;
+    pipelineCacheCreateInfo.flags = 0;
+    pipelineCacheCreateInfo.initialDataSize = 0;
+    pipelineCacheCreateInfo.pInitialData = NULL;
+
+    VkResult result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, NULL, &pipelineCache);
+    ASSERT_VULKAN(result);
+}
+
+void loadShaders()
+{
+    shaderCodeVert = readFile("vert.spv");
+    shaderCodeFrag = readFile("frag.spv");
+    if (useOcclusionCulling)
+    {
+        shaderCodeDepthPyramid = readFile("depthPyramid.spv");
+        shaderCodeOcclusionCull = readFile("occlusionCull.spv");
+    }
+}
+
+void createShaderModules()
+{
+    createShaderModule(shaderCodeVert, &shaderModuleVert);
+    createShaderModule(shaderCodeFrag, &shaderModuleFrag);
+    if (useOcclusionCulling)
+    {
+        createShaderModule(shaderCodeDepthPyramid, &shaderModuleDepthPyramid);
+        createShaderModule(shaderCodeOcclusionCull, &shaderModuleOcclusionCull);
+    }
+}
+
+void createPipeline()
+{
+    VkPushConstantRange pushConstantRange;
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(MeshPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo;
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.pNext = NULL;
+    pipelineLayoutCreateInfo.flags = 0;
+    pipelineLayoutCreateInfo.setLayoutCount = 0;
+    pipelineLayoutCreateInfo.pSetLayouts = NULL;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+    VkResult result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, NULL, &pipelineLayout);
+    ASSERT_VULKAN(result);
+
+    if (useDepthPrepass)
+    {
+        depthPrepassPipeline = createGraphicsPipeline(depthPrepassRenderPass, true, VK_COMPARE_OP_LESS, VK_TRUE);
+        pipeline = createGraphicsPipeline(renderPass, false, VK_COMPARE_OP_LESS_OR_EQUAL, VK_FALSE);
+    }
+    else
+    {
+        pipeline = createGraphicsPipeline(renderPass, false, VK_COMPARE_OP_LESS, VK_TRUE);
+    }
+
+    //DrawCommand::pipeline indexes this table
+    pipelineTable = {pipeline};
+
+    //The draws of the late phase are not in the depth prepass, they have to test and write depth themselves
+    if (useOcclusionCulling)
+    {
+        latePipeline = useDepthPrepass ? createGraphicsPipeline(lateRenderPass, false, VK_COMPARE_OP_LESS, VK_TRUE) : pipeline;
+        latePipelineTable = {latePipeline};
+    }
+}
+
+VkDescriptorSetLayout createDescriptorSetLayout(const std::vector<VkDescriptorType> &types)
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings(types.size());
+    for (uint32_t i = 0; i < types.size(); i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = types[i];
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].pImmutableSamplers = NULL;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
+    descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.pNext = NULL;
+    descriptorSetLayoutCreateInfo.flags = 0;
+    descriptorSetLayoutCreateInfo.bindingCount = bindings.size();
+    descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout setLayout;
+    VkResult result = vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo, NULL, &setLayout);
+    ASSERT_VULKAN(result);
+    return setLayout;
+}
+
+VkPipeline createComputePipeline(VkShaderModule shaderModule, VkPipelineLayout layout)
+{
+    VkComputePipelineCreateInfo pipelineCreateInfo;
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.pNext = NULL;
+    pipelineCreateInfo.flags = 0;
+    pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineCreateInfo.stage.pNext = NULL;
+    pipelineCreateInfo.stage.flags = 0;
+    pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineCreateInfo.stage.module = shaderModule;
+    pipelineCreateInfo.stage.pName = "main";
+    pipelineCreateInfo.stage.pSpecializationInfo = NULL;
+    pipelineCreateInfo.layout = layout;
+    pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineCreateInfo.basePipelineIndex = -1;
+
+    VkPipeline computePipeline;
+    VkResult result = vkCreateComputePipelines(device, pipelineCache, 1, &pipelineCreateInfo, NULL, &computePipeline);
+    ASSERT_VULKAN(result);
+    return computePipeline;
+}
+
+//Independent of the swapchain, these stay until shutdown
+void createOcclusionCullingPipelines()
+{
+    depthPyramidSetLayout = createDescriptorSetLayout({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE});
+    cullSetLayout = createDescriptorSetLayout({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                               VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER});
+
+    //The last source texel of depthPyramid.comp
+    VkPushConstantRange pushConstantRange;
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = 2 * sizeof(int32_t);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo;
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.pNext = NULL;
+    pipelineLayoutCreateInfo.flags = 0;
+    pipelineLayoutCreateInfo.setLayoutCount = 1;
+    pipelineLayoutCreateInfo.pSetLayouts = &depthPyramidSetLayout;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+    VkResult result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, NULL, &depthPyramidPipelineLayout);
+    ASSERT_VULKAN(result);
+
+    pushConstantRange.size = sizeof(CullPushConstants);
+    pipelineLayoutCreateInfo.pSetLayouts = &cullSetLayout;
+
+    result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, NULL, &cullPipelineLayout);
+    ASSERT_VULKAN(result);
+
+    depthPyramidPipeline = createComputePipeline(shaderModuleDepthPyramid, depthPyramidPipelineLayout);
+    cullPipeline = createComputePipeline(shaderModuleOcclusionCull, cullPipelineLayout);
+
+    //The shaders only fetch texels, the sampler is there because the descriptors need one
+    VkSamplerCreateInfo samplerCreateInfo;
+    samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerCreateInfo.pNext = NULL;
+    samplerCreateInfo.flags = 0;
+    samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+    samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+    samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.mipLodBias = 0.f;
+    samplerCreateInfo.anisotropyEnable = VK_FALSE;
+    samplerCreateInfo.maxAnisotropy = 1.f;
+    samplerCreateInfo.compareEnable = VK_FALSE;
+    samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
+    samplerCreateInfo.minLod = 0.f;
+    samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+    samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+
+    result = vkCreateSampler(device, &samplerCreateInfo, NULL, &depthPyramidSampler);
+    ASSERT_VULKAN(result);
+}
+
+void destroyOcclusionCullingPipelines()
+{
+    vkDestroySampler(device, depthPyramidSampler, NULL);
+    vkDestroyPipeline(device, depthPyramidPipeline, NULL);
+    vkDestroyPipeline(device, cullPipeline, NULL);
+    vkDestroyPipelineLayout(device, depthPyramidPipelineLayout, NULL);
+    vkDestroyPipelineLayout(device, cullPipelineLayout, NULL);
+    vkDestroyDescriptorSetLayout(device, depthPyramidSetLayout, NULL);
+    vkDestroyDescriptorSetLayout(device, cullSetLayout, NULL);
+    vkDestroyShaderModule(device, shaderModuleDepthPyramid, NULL);
+    vkDestroyShaderModule(device, shaderModuleOcclusionCull, NULL);
+}
+
+VkExtent2D getScaledExtent(float scale)
+{
+    return {std::max(1u, uint32_t(width * scale)), std::max(1u, uint32_t(height * scale))};
+}
+
+//Size of the scene targets. With dynamic resolution frames only render into the top left renderExtent of them
+VkExtent2D getRenderTargetExtent()
+{
+    if (useDynamicResolution)
+        return getScaledExtent(dynamicResolution.allocatedScale);
+    return {width, height};
+}
+
+void createFramebuffers()
+{
+    VkImageView depthImageView = renderGraphGetImageView(renderGraph, depthResource);
+    VkExtent2D targetExtent = getRenderTargetExtent();
+
+    for (size_t i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        VkImageView colorImageView = useDynamicResolution ? renderGraphGetImageView(renderGraph, sceneColorResource) : imageViews[i];
+        VkImageView attachments[] = {colorImageView, depthImageView};
+
+        VkFramebufferCreateInfo framebufferCreateInfo;
+        framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferCreateInfo.pNext = NULL;
+        framebufferCreateInfo.flags = 0;
+        framebufferCreateInfo.renderPass = renderPass;
+        framebufferCreateInfo.attachmentCount = 2;
+        framebufferCreateInfo.pAttachments = attachments;
+        framebufferCreateInfo.width = targetExtent.width;
+        framebufferCreateInfo.height = targetExtent.height;
+        framebufferCreateInfo.layers = 1;
+
+        framebuffers.resize(amountOfImagesInSwapchain);
+        VkResult result = vkCreateFramebuffer(device, &framebufferCreateInfo, NULL, &(framebuffers.data()[i]));
+        ASSERT_VULKAN(result);
+    }
+
+    if (!useDepthPrepass)
+        return;
+
+    VkFramebufferCreateInfo framebufferCreateInfo;
+    framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferCreateInfo.pNext = NULL;
+    framebufferCreateInfo.flags = 0;
+    framebufferCreateInfo.renderPass = depthPrepassRenderPass;
+    framebufferCreateInfo.attachmentCount = 1;
+    framebufferCreateInfo.pAttachments = &depthImageView;
+    framebufferCreateInfo.width = targetExtent.width;
+    framebufferCreateInfo.height = targetExtent.height;
+    framebufferCreateInfo.layers = 1;
+
+    VkResult result = vkCreateFramebuffer(device, &framebufferCreateInfo, NULL, &depthPrepassFramebuffer);
+    ASSERT_VULKAN(result);
+}
+
+void destroyFramebuffers()
+{
+    for (size_t i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        vkDestroyFramebuffer(device, framebuffers.data()[i], NULL);
+    }
+    if (useDepthPrepass)
+        vkDestroyFramebuffer(device, depthPrepassFramebuffer, NULL);
+}
+
+VkImageView createDepthPyramidView(uint32_t baseLevel, uint32_t levelCount)
+{
+    VkImageViewCreateInfo imageViewCreateInfo;
+    imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    imageViewCreateInfo.pNext = NULL;
+    imageViewCreateInfo.flags = 0;
+    imageViewCreateInfo.image = depthPyramidImage;
+    imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    imageViewCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+    imageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    imageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    imageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageViewCreateInfo.subresourceRange.baseMipLevel = baseLevel;
+    imageViewCreateInfo.subresourceRange.levelCount = levelCount;
+    imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    imageViewCreateInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view;
+    VkResult result = vkCreateImageView(device, &imageViewCreateInfo, NULL, &view);
+    ASSERT_VULKAN(result);
+    return view;
+}
+
+//Half the size of the scene targets, with levels down to one texel. The descriptor sets are written by
+//writeDepthPyramidDescriptors once the render graph created the depth buffer
+void createDepthPyramid(VkExtent2D targetExtent)
+{
+    depthPyramidExtent = {(targetExtent.width + 1) / 2, (targetExtent.height + 1) / 2};
+    depthPyramidLevels = 1;
+    while ((std::max(depthPyramidExtent.width, depthPyramidExtent.height) >> depthPyramidLevels) > 0)
+        depthPyramidLevels++;
+    depthPyramidInitialized = false;
+    depthPyramidBuilt = false;
+
+    VkImageCreateInfo imageCreateInfo;
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.pNext = NULL;
+    imageCreateInfo.flags = 0;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+    imageCreateInfo.extent = {depthPyramidExtent.width, depthPyramidExtent.height, 1};
+    imageCreateInfo.mipLevels = depthPyramidLevels;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.queueFamilyIndexCount = 0;
+    imageCreateInfo.pQueueFamilyIndices = NULL;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkResult result = vkCreateImage(device, &imageCreateInfo, NULL, &depthPyramidImage);
+    ASSERT_VULKAN(result);
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(device, depthPyramidImage, &memoryRequirements);
+    int memoryTypeIndex = findMemoryTypeIndex(memoryProperties, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (memoryTypeIndex < 0)
+        memoryTypeIndex = findMemoryTypeIndex(memoryProperties, memoryRequirements.memoryTypeBits, 0);
+
+    VkMemoryAllocateInfo memoryAllocateInfo;
+    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memoryAllocateInfo.pNext = NULL;
+    memoryAllocateInfo.allocationSize = memoryRequirements.size;
+    memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    result = vkAllocateMemory(device, &memoryAllocateInfo, NULL, &depthPyramidMemory);
+    ASSERT_VULKAN(result);
+    result = vkBindImageMemory(device, depthPyramidImage, depthPyramidMemory, 0);
+    ASSERT_VULKAN(result);
+
+    depthPyramidView = createDepthPyramidView(0, depthPyramidLevels);
+    depthPyramidLevelViews.resize(depthPyramidLevels);
+    for (uint32_t level = 0; level < depthPyramidLevels; level++)
+    {
+        depthPyramidLevelViews[level] = createDepthPyramidView(level, 1);
+    }
+
+    VkDescriptorPoolSize poolSizes[2];
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = depthPyramidLevels;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = depthPyramidLevels;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
+    descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.pNext = NULL;
+    descriptorPoolCreateInfo.flags = 0;
+    descriptorPoolCreateInfo.maxSets = depthPyramidLevels;
+    descriptorPoolCreateInfo.poolSizeCount = 2;
+    descriptorPoolCreateInfo.pPoolSizes = poolSizes;
+
+    result = vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, NULL, &depthPyramidDescriptorPool);
+    ASSERT_VULKAN(result);
+
+    std::vector<VkDescriptorSetLayout> setLayouts(depthPyramidLevels, depthPyramidSetLayout);
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo;
+    descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.pNext = NULL;
+    descriptorSetAllocateInfo.descriptorPool = depthPyramidDescriptorPool;
+    descriptorSetAllocateInfo.descriptorSetCount = depthPyramidLevels;
+    descriptorSetAllocateInfo.pSetLayouts = setLayouts.data();
+
+    depthPyramidDescriptorSets.resize(depthPyramidLevels);
+    result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, depthPyramidDescriptorSets.data());
+    ASSERT_VULKAN(result);
+}
+
+//Level 0 reads the depth buffer, every other level the one before it
+void writeDepthPyramidDescriptors(VkImageView depthImageView)
+{
+    std::vector<VkDescriptorImageInfo> imageInfos(depthPyramidLevels * 2);
+    std::vector<VkWriteDescriptorSet> writes(depthPyramidLevels * 2);
+    for (uint32_t level = 0; level < depthPyramidLevels; level++)
+    {
+        VkDescriptorImageInfo &sourceInfo = imageInfos[level * 2];
+        sourceInfo.sampler = depthPyramidSampler;
+        sourceInfo.imageView = level == 0 ? depthImageView : depthPyramidLevelViews[level - 1];
+        sourceInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorImageInfo &destinationInfo = imageInfos[level * 2 + 1];
+        destinationInfo.sampler = VK_NULL_HANDLE;
+        destinationInfo.imageView = depthPyramidLevelViews[level];
+        destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        for (uint32_t binding = 0; binding < 2; binding++)
+        {
+            VkWriteDescriptorSet &write = writes[level * 2 + binding];
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.pNext = NULL;
+            write.dstSet = depthPyramidDescriptorSets[level];
+            write.dstBinding = binding;
+            write.dstArrayElement = 0;
+            write.descriptorCount = 1;
+            write.descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            write.pImageInfo = &imageInfos[level * 2 + binding];
+            write.pBufferInfo = NULL;
+            write.pTexelBufferView = NULL;
+        }
+    }
+    vkUpdateDescriptorSets(device, writes.size(), writes.data(), 0, NULL);
+}
+
+void destroyDepthPyramid()
+{
+    vkDestroyDescriptorPool(device, depthPyramidDescriptorPool, NULL);
+    depthPyramidDescriptorSets.clear();
+    for (VkImageView view : depthPyramidLevelViews)
+    {
+        vkDestroyImageView(device, view, NULL);
+    }
+    depthPyramidLevelViews.clear();
+    vkDestroyImageView(device, depthPyramidView, NULL);
+    vkDestroyImage(device, depthPyramidImage, NULL);
+    vkFreeMemory(device, depthPyramidMemory, NULL);
+}
+
+void createCommandPool()
+{
+    VkCommandPoolCreateInfo commandPoolCreateInfo;
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCreateInfo.pNext = NULL;
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = 0;
+
+    VkResult result = vkCreateCommandPool(device, &commandPoolCreateInfo, NULL, &commandPool);
+    ASSERT_VULKAN(result);
+}
+
+void createCommandBuffers()
+{
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo;
+    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocateInfo.pNext = NULL;
+    commandBufferAllocateInfo.commandPool = commandPool;
+    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.commandBufferCount = amountOfImagesInSwapchain;
+
+    commandBuffers.resize(amountOfImagesInSwapchain);
+    VkResult result = vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, commandBuffers.data());
+    ASSERT_VULKAN(result);
+}
+
+//Command buffers are recorded every frame, a fence per swapchain image tells when one is free again
+void createFences()
+{
+    VkFenceCreateInfo fenceCreateInfo;
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.pNext = NULL;
+    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    commandBufferFences.resize(amountOfImagesInSwapchain);
+    for (size_t i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        VkResult result = vkCreateFence(device, &fenceCreateInfo, NULL, &commandBufferFences[i]);
+        ASSERT_VULKAN(result);
+    }
+}
+
+void createTimestampQueries()
+{
+    if (!useDynamicResolution)
+        return;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    uint32_t amountOfQueueFamilies = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &amountOfQueueFamilies, NULL);
+    std::vector<VkQueueFamilyProperties> familyProperties(amountOfQueueFamilies);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &amountOfQueueFamilies, familyProperties.data());
+    uint32_t validBits = familyProperties[0].timestampValidBits;
+    timestampsWritten.assign(amountOfImagesInSwapchain, false);
+    frameRenderScales.assign(amountOfImagesInSwapchain, 1.f);
+    if (validBits == 0)
+    {
+        //Writing timestamps is invalid then, without a pool the controller gets no input and the scale stays
+        //where it is
+        std::cerr << "Queue family 0 has no timestamps, dynamic resolution is fixed at scale " << dynamicResolution.scale << std::endl;
+        return;
+    }
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryPoolCreateInfo;
+    queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolCreateInfo.pNext = NULL;
+    queryPoolCreateInfo.flags = 0;
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCreateInfo.queryCount = amountOfImagesInSwapchain * 2;
+    queryPoolCreateInfo.pipelineStatistics = 0;
+
+    VkResult result = vkCreateQueryPool(device, &queryPoolCreateInfo, NULL, &timestampQueryPool);
+    ASSERT_VULKAN(result);
+}
+
+void destroyTimestampQueries()
+{
+    if (timestampQueryPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(device, timestampQueryPool, NULL);
+    timestampQueryPool = VK_NULL_HANDLE;
+}
+
+void destroyFences()
+{
+    for (auto &&fence : commandBufferFences)
+    {
+        vkDestroyFence(device, fence, NULL);
+    }
+    commandBufferFences.clear();
+}
+
+//Host visible and coherent, stays mapped for the lifetime of the buffer. Returns the mapping
+void *createMappedBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &memory)
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    VkBufferCreateInfo bufferCreateInfo;
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.pNext = NULL;
+    bufferCreateInfo.flags = 0;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = usage;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bufferCreateInfo.queueFamilyIndexCount = 0;
+    bufferCreateInfo.pQueueFamilyIndices = NULL;
+
+    VkResult result = vkCreateBuffer(device, &bufferCreateInfo, NULL, &buffer);
+    ASSERT_VULKAN(result);
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+
+    VkMemoryAllocateInfo memoryAllocateInfo;
+    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memoryAllocateInfo.pNext = NULL;
+    memoryAllocateInfo.allocationSize = memoryRequirements.size;
+    memoryAllocateInfo.memoryTypeIndex = findMemoryTypeIndex(memoryProperties, memoryRequirements.memoryTypeBits,
+                                                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    result = vkAllocateMemory(device, &memoryAllocateInfo, NULL, &memory);
+    ASSERT_VULKAN(result);
+    result = vkBindBufferMemory(device, buffer, memory, 0);
+    ASSERT_VULKAN(result);
+
+    void *data;
+    result = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data);
+    ASSERT_VULKAN(result);
+    return data;
+}
+
+void createTransformBuffers(uint32_t capacity)
+{
+    transformBufferCapacity = capacity;
+    transformBuffers.resize(amountOfImagesInSwapchain);
+    transformBufferMemory.resize(amountOfImagesInSwapchain);
+    transformBufferData.resize(amountOfImagesInSwapchain);
+    //Version 0 is older than every update, so the first use writes the whole buffer
+    transformBufferVersions.assign(amountOfImagesInSwapchain, 0);
+    for (uint32_t i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        //The cull shader reads the matrices as well
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | (useOcclusionCulling ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT : 0);
+        transformBufferData[i] = (Matrix4 *)createMappedBuffer(capacity * sizeof(Matrix4), usage, transformBuffers[i], transformBufferMemory[i]);
+    }
+}
+
+void destroyTransformBuffers()
+{
+    for (size_t i = 0; i < transformBuffers.size(); i++)
+    {
+        vkDestroyBuffer(device, transformBuffers[i], NULL);
+        vkFreeMemory(device, transformBufferMemory[i], NULL);
+    }
+    transformBuffers.clear();
+    transformBufferMemory.clear();
+    transformBufferData.clear();
+    transformBufferVersions.clear();
+    transformBufferCapacity = 0;
+}
+
+void createCullBuffers(uint32_t capacity)
+{
+    cullBufferCapacity = capacity;
+    cullDrawBuffers.resize(amountOfImagesInSwapchain);
+    cullDrawBufferMemory.resize(amountOfImagesInSwapchain);
+    cullDrawBufferData.resize(amountOfImagesInSwapchain);
+    indirectBuffers.resize(amountOfImagesInSwapchain);
+    indirectBufferMemory.resize(amountOfImagesInSwapchain);
+    indirectBufferData.resize(amountOfImagesInSwapchain);
+    indirectDrawCounts.assign(amountOfImagesInSwapchain, 0);
+    for (uint32_t i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        cullDrawBufferData[i] = (CullDraw *)createMappedBuffer(capacity * sizeof(CullDraw), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                               cullDrawBuffers[i], cullDrawBufferMemory[i]);
+        indirectBufferData[i] = (VkDrawIndexedIndirectCommand *)createMappedBuffer(2 * capacity * sizeof(VkDrawIndexedIndirectCommand),
+                                                                                   VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                                                   indirectBuffers[i], indirectBufferMemory[i]);
+    }
+
+    VkDescriptorPoolSize poolSizes[2];
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = amountOfImagesInSwapchain;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = amountOfImagesInSwapchain * 3;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
+    descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.pNext = NULL;
+    descriptorPoolCreateInfo.flags = 0;
+    descriptorPoolCreateInfo.maxSets = amountOfImagesInSwapchain;
+    descriptorPoolCreateInfo.poolSizeCount = 2;
+    descriptorPoolCreateInfo.pPoolSizes = poolSizes;
+
+    VkResult result = vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, NULL, &cullDescriptorPool);
+    ASSERT_VULKAN(result);
+
+    std::vector<VkDescriptorSetLayout> setLayouts(amountOfImagesInSwapchain, cullSetLayout);
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo;
+    descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.pNext = NULL;
+    descriptorSetAllocateInfo.descriptorPool = cullDescriptorPool;
+    descriptorSetAllocateInfo.descriptorSetCount = amountOfImagesInSwapchain;
+    descriptorSetAllocateInfo.pSetLayouts = setLayouts.data();
+
+    cullDescriptorSets.resize(amountOfImagesInSwapchain);
+    result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, cullDescriptorSets.data());
+    ASSERT_VULKAN(result);
+}
+
+void destroyCullBuffers()
+{
+    for (size_t i = 0; i < cullDrawBuffers.size(); i++)
+    {
+        vkDestroyBuffer(device, cullDrawBuffers[i], NULL);
+        vkFreeMemory(device, cullDrawBufferMemory[i], NULL);
+        vkDestroyBuffer(device, indirectBuffers[i], NULL);
+        vkFreeMemory(device, indirectBufferMemory[i], NULL);
+    }
+    if (!cullDrawBuffers.empty())
+        vkDestroyDescriptorPool(device, cullDescriptorPool, NULL);
+    cullDrawBuffers.clear();
+    cullDrawBufferMemory.clear();
+    cullDrawBufferData.clear();
+    indirectBuffers.clear();
+    indirectBufferMemory.clear();
+    indirectBufferData.clear();
+    indirectDrawCounts.clear();
+    cullDescriptorSets.clear();
+    cullBufferCapacity = 0;
+}
+
+//Runs before the device exists, only fills sceneMesh
+void loadSceneMesh()
+{
+    MeshData data;
+    if (meshFilename)
+    {
+        loadMesh(meshFilename, data, std::max(1u, std::thread::hardware_concurrency()));
+    }
+    else
+    {
+        data.positions = {0.f, -0.5f, 0.f, 0.5f, 0.5f, 0.f, -0.5f, 0.5f, 0.f};
+        data.normals = {0.f, 0.f, -1.f, 0.f, 0.f, -1.f, 0.f, 0.f, -1.f};
+        data.uvs = {0.f, 0.f, 1.f, 0.f, 0.f, 1.f};
+        data.indices = {0, 1, 2};
+    }
+    buildLodChain(data);
+    quantizeMesh(data, sceneMesh);
+
+    //Loaded models are fitted into the size of the built in triangle and flattened, so they stay inside
+    //the depth layer of their draw
+    float fit = meshFilename ? 0.5f / std::max(sceneMesh.bounds[3], 1e-20f) : 1.f;
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        float axisFit = axis == 2 && meshFilename ? fit * 0.01f : fit;
+        meshPushConstants.positionScale[axis] = sceneMesh.positionScale[axis] * axisFit;
+        meshPushConstants.positionOffset[axis] = (sceneMesh.positionOffset[axis] - sceneMesh.bounds[axis]) * axisFit;
+    }
+    meshPushConstants.positionScale[3] = 0.f;
+    meshPushConstants.positionOffset[3] = 1.f;
+    meshLodScale = fit;
+}
+
+void createMeshBuffers()
+{
+    size_t vertexBytes = sceneMesh.vertices.size() * sizeof(QuantizedVertex);
+    void *vertices = createMappedBuffer(vertexBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, meshVertexBuffer, meshVertexBufferMemory);
+    memcpy(vertices, sceneMesh.vertices.data(), vertexBytes);
+
+    size_t indexBytes = sceneMesh.indices.size() * sizeof(uint32_t);
+    void *indices = createMappedBuffer(indexBytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, meshIndexBuffer, meshIndexBufferMemory);
+    memcpy(indices, sceneMesh.indices.data(), indexBytes);
+}
+
+void destroyMeshBuffers()
+{
+    vkDestroyBuffer(device, meshVertexBuffer, NULL);
+    vkFreeMemory(device, meshVertexBufferMemory, NULL);
+    vkDestroyBuffer(device, meshIndexBuffer, NULL);
+    vkFreeMemory(device, meshIndexBufferMemory, NULL);
+}
+
+void buildScene()
+{
+    const float bounds[4] = {0.f, 0.f, 0.f, 0.5f};
+    sceneClear(scene);
+    sceneRows.clear();
+    sceneLeaves.clear();
+    sceneLeafLods.assign(sceneDrawCount, 0);
+
+    sceneRoot = sceneAddNode(scene, SCENE_NO_PARENT, Transform(), bounds);
+    for (uint32_t row = 0; row < (sceneDrawCount + 7) / 8; row++)
+    {
+        Transform local;
+        local.position[1] = ((row % 8) - 3.5f) * 0.05f;
+        sceneRows.push_back(sceneAddNode(scene, sceneRoot, local, bounds));
+    }
+    for (uint32_t layer = 0; layer < sceneDrawCount; layer++)
+    {
+        Transform local;
+        local.position[0] = ((layer % 8) - 3.5f) * 0.05f;
+        local.position[2] = (layer + 1) / float(sceneDrawCount + 1);
+        sceneLeaves.push_back(sceneAddNode(scene, sceneRows[layer / 8], local, bounds));
+    }
+}
+
+//The rows sway, the root follows the cursor
+void animateScene()
+{
+    if (sceneLeaves.size() != sceneDrawCount)
+        buildScene();
+
+    if (cursorOffset[0] != sceneRootOffset[0] || cursorOffset[1] != sceneRootOffset[1])
+    {
+        Transform root;
+        root.position[0] = sceneRootOffset[0] = cursorOffset[0];
+        root.position[1] = sceneRootOffset[1] = cursorOffset[1];
+        sceneSetLocalTransform(scene, sceneRoot, root);
+    }
+
+    for (uint32_t row = 0; row < sceneRows.size(); row++)
+    {
+        Transform local;
+        local.position[0] = 0.02f * sinf(float(simulationState.time) + row * 0.8f);
+        local.position[1] = ((row % 8) - 3.5f) * 0.05f;
+        sceneSetLocalTransform(scene, sceneRows[row], local);
+    }
+
+    sceneUpdate(scene, std::thread::hardware_concurrency());
+}
+
+//Called once the fence of the image was waited on, so the GPU is done with its buffer
+void uploadTransforms(uint32_t imageIndex)
+{
+    if (transformBuffers.size() != amountOfImagesInSwapchain || transformBufferCapacity < sceneGetNodeCount(scene))
+    {
+        vkDeviceWaitIdle(device);
+        destroyTransformBuffers();
+        createTransformBuffers(std::max(sceneGetNodeCount(scene), 64u));
+    }
+    sceneUploadWorldMatrices(scene, transformBufferData[imageIndex], transformBufferVersions[imageIndex]);
+}
+
+//Called after uploadTransforms. Counts the draws both phases culled the last time the image was drawn, then
+//hands the draws of this frame to the cull shader
+void uploadCullDraws(uint32_t imageIndex)
+{
+    uint32_t drawCount = drawList.sorted.size();
+    if (cullDrawBuffers.size() != amountOfImagesInSwapchain || cullBufferCapacity < drawCount)
+    {
+        vkDeviceWaitIdle(device);
+        destroyCullBuffers();
+        createCullBuffers(std::max(drawCount, 64u));
+    }
+
+    const VkDrawIndexedIndirectCommand *commands = indirectBufferData[imageIndex];
+    uint32_t previousDrawCount = indirectDrawCounts[imageIndex];
+    uint32_t culledDraws = 0;
+    for (uint32_t i = 0; i < previousDrawCount; i++)
+    {
+        if (commands[i].instanceCount == 0 && commands[previousDrawCount + i].instanceCount == 0)
+            culledDraws++;
+    }
+    lastFrameTimings.culledDraws = culledDraws;
+    indirectDrawCounts[imageIndex] = drawCount;
+
+    for (uint32_t i = 0; i < drawCount; i++)
+    {
+        const DrawCommand &command = drawList.commands[getDrawSortKeyCommand(drawList.sorted[i])];
+        CullDraw &draw = cullDrawBufferData[imageIndex][i];
+        draw.indexCount = command.indexCount;
+        draw.firstIndex = command.firstIndex;
+        draw.vertexOffset = command.vertexOffset;
+        draw.transform = command.transform;
+    }
+
+    //The pyramid and the transform buffer can have been recreated since the set was used
+    VkDescriptorImageInfo pyramidInfo;
+    pyramidInfo.sampler = depthPyramidSampler;
+    pyramidInfo.imageView = depthPyramidView;
+    pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkDescriptorBufferInfo bufferInfos[3];
+    bufferInfos[0] = {transformBuffers[imageIndex], 0, VK_WHOLE_SIZE};
+    bufferInfos[1] = {cullDrawBuffers[imageIndex], 0, VK_WHOLE_SIZE};
+    bufferInfos[2] = {indirectBuffers[imageIndex], 0, VK_WHOLE_SIZE};
+
+    VkWriteDescriptorSet writes[4];
+    for (uint32_t binding = 0; binding < 4; binding++)
+    {
+        writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].pNext = NULL;
+        writes[binding].dstSet = cullDescriptorSets[imageIndex];
+        writes[binding].dstBinding = binding;
+        writes[binding].dstArrayElement = 0;
+        writes[binding].descriptorCount = 1;
+        writes[binding].descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[binding].pImageInfo = binding == 0 ? &pyramidInfo : NULL;
+        writes[binding].pBufferInfo = binding == 0 ? NULL : &bufferInfos[binding - 1];
+        writes[binding].pTexelBufferView = NULL;
+    }
+    vkUpdateDescriptorSets(device, 4, writes, 0, NULL);
+}
+
+//Pixels covered by one unit of the mesh, for the draw with this world matrix. shader.vert has no view or
+//projection, the world matrix maps straight into clip space with w = 1, so this only follows the scale of the
+//node and the render extent, never the depth of the draw
+float getPixelsPerMeshUnit(const Matrix4 &world)
+{
+    float scale = 0.f;
+    for (uint32_t column = 0; column < 3; column++)
+    {
+        const float *axis = &world.m[column * 4];
+        scale = std::max(scale, axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    }
+    //Clip space spans two units over the viewport
+    return sqrtf(scale) * meshLodScale * 0.5f * std::max(renderExtent.width, renderExtent.height);
+}
+
+void buildDrawList()
+{
+    animateScene();
+
+    uint32_t triangleCount = 0;
+    clearDrawList(drawList);
+    for (uint32_t i = 0; i < sceneLeaves.size(); i++)
+    {
+        uint32_t slot = sceneGetSlot(scene, sceneLeaves[i]);
+        uint32_t &lod = sceneLeafLods[i];
+        if (lodPixelError > 0.f)
+            lod = selectLod(sceneMesh.lods, getPixelsPerMeshUnit(scene.worldMatrices[slot]), lodPixelError, lodHysteresis, lod);
+        else
+            lod = 0;
+
+        DrawCommand command;
+        command.pipeline = 0;
+        command.descriptorSet = 0;
+        command.depth = scene.worldMatrices[slot].m[14];
+        command.translucent = false;
+        command.transform = slot;
+        command.indexCount = sceneMesh.lods[lod].indexCount;
+        command.firstIndex = sceneMesh.lods[lod].firstIndex;
+        command.vertexOffset = 0;
+        addDraw(drawList, command);
+        triangleCount += command.indexCount / 3;
+    }
+    sortDrawList(drawList);
+    lastFrameTimings.triangleCount = triangleCount;
+}
+
+//Viewport and scissor cover the renderExtent of the frame being recorded
+void setViewport(VkCommandBuffer commandBuffer)
+{
+    VkViewport viewport;
+    viewport.x = 0.f;
+    viewport.y = 0.f;
+    viewport.width = renderExtent.width;
+    viewport.height = renderExtent.height;
+    viewport.minDepth = 0.f;
+    viewport.maxDepth = 1.f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor;
+    scissor.offset = {0, 0};
+    scissor.extent = renderExtent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+//One multi draw per run, split where the device limit asks for it. Without multiDrawIndirect every draw is its own
+void recordIndirectDraws(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount)
+{
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    uint32_t maxDraws = std::max(1u, maxDrawIndirectCount);
+    for (uint32_t first = 0; first < drawCount; first += maxDraws)
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset + first * stride, std::min(maxDraws, drawCount - first), stride);
+    }
+}
+
+//Same order as without culling, but the draws come from the indirect commands the cull shader wrote for the
+//phase. Runs of draws with the same pipeline go out together
+void recordCulledDraws(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool depthPrepass, bool late)
+{
+    const std::vector<VkPipeline> &pipelines = late ? latePipelineTable : pipelineTable;
+    uint32_t drawCount = drawList.sorted.size();
+    uint32_t firstCommand = late ? drawCount : 0;
+    uint32_t boundPipeline = std::numeric_limits<uint32_t>::max();
+    uint32_t runStart = 0;
+    while (runStart < drawCount)
+    {
+        const DrawCommand &command = drawList.commands[getDrawSortKeyCommand(drawList.sorted[runStart])];
+        uint32_t runEnd = runStart + 1;
+        while (runEnd < drawCount)
+        {
+            const DrawCommand &next = drawList.commands[getDrawSortKeyCommand(drawList.sorted[runEnd])];
+            if (next.pipeline != command.pipeline || next.translucent != command.translucent)
+                break;
+            runEnd++;
+        }
+
+        if (!(depthPrepass && command.translucent))
+        {
+            if (!depthPrepass && command.pipeline != boundPipeline)
+            {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[command.pipeline]);
+                boundPipeline = command.pipeline;
+            }
+            recordIndirectDraws(commandBuffer, indirectBuffers[imageIndex], (firstCommand + runStart) * sizeof(VkDrawIndexedIndirectCommand),
+                                runEnd - runStart);
+        }
+        runStart = runEnd;
+    }
+}
+
+//Submits the sorted draws, state is only rebound when the key changes it
+void recordDraws(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool depthPrepass, bool late)
+{
+    setViewport(commandBuffer);
+    VkBuffer vertexBuffers[] = {transformBuffers[imageIndex], meshVertexBuffer};
+    VkDeviceSize offsets[] = {0, 0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, meshIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(meshPushConstants), &meshPushConstants);
+
+    if (useOcclusionCulling)
+    {
+        recordCulledDraws(commandBuffer, imageIndex, depthPrepass, late);
+        return;
+    }
+
+    uint32_t boundPipeline = std::numeric_limits<uint32_t>::max();
+    for (uint64_t key : drawList.sorted)
+    {
+        const DrawCommand &command = drawList.commands[getDrawSortKeyCommand(key)];
+        if (depthPrepass && command.translucent)
+            continue;
+
+        if (!depthPrepass && command.pipeline != boundPipeline)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineTable[command.pipeline]);
+            boundPipeline = command.pipeline;
+        }
+        vkCmdDrawIndexed(commandBuffer, command.indexCount, 1, command.firstIndex, command.vertexOffset, command.transform);
+    }
+}
+
+void recordDepthPrepass(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    VkRenderPassBeginInfo renderPassBeginInfo;
+    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext = NULL;
+    renderPassBeginInfo.renderPass = depthPrepassRenderPass;
+    renderPassBeginInfo.framebuffer = depthPrepassFramebuffer;
+    renderPassBeginInfo.renderArea.offset = {0, 0};
+    renderPassBeginInfo.renderArea.extent = renderExtent;
+    VkClearValue clearValue;
+    clearValue.depthStencil = {1.f, 0};
+    renderPassBeginInfo.clearValueCount = 1;
+    renderPassBeginInfo.pClearValues = &clearValue;
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depthPrepassPipeline);
+    recordDraws(commandBuffer, imageIndex, true, false);
+
+    vkCmdEndRenderPass(commandBuffer);
+}
+
+void recordMainPass(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    VkRenderPassBeginInfo renderPassBeginInfo;
+    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext = NULL;
+    renderPassBeginInfo.renderPass = renderPass;
+    renderPassBeginInfo.framebuffer = framebuffers[imageIndex];
+    renderPassBeginInfo.renderArea.offset = {0, 0};
+    renderPassBeginInfo.renderArea.extent = renderExtent;
+    VkClearValue clearValues[2];
+    clearValues[0].color = {{0.f, 0.f, 0.f, 1.f}};
+    clearValues[1].depthStencil = {1.f, 0};
+    renderPassBeginInfo.clearValueCount = 2;
+    renderPassBeginInfo.pClearValues = clearValues;
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    recordDraws(commandBuffer, imageIndex, false, false);
+
+    vkCmdEndRenderPass(commandBuffer);
+}
+
+//Writes the indirect commands of one phase, see occlusionCull.comp. Until a pyramid was built the early phase
+//only tests the frustum
+void recordCull(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool late)
+{
+    uint32_t drawCount = drawList.sorted.size();
+    VkExtent2D viewport = late ? renderExtent : depthPyramidViewport;
+
+    //The box the mesh was quantized in, see shader.vert
+    CullPushConstants pushConstants;
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        pushConstants.boxCenter[axis] = meshPushConstants.positionOffset[axis];
+        pushConstants.boxExtent[axis] = meshPushConstants.positionScale[axis];
+    }
+    pushConstants.boxCenter[3] = 1.f;
+    pushConstants.boxExtent[3] = 0.f;
+    pushConstants.viewport[0] = viewport.width;
+    pushConstants.viewport[1] = viewport.height;
+    pushConstants.drawCount = drawCount;
+    pushConstants.late = late ? 1 : 0;
+    pushConstants.pyramidLevels = late || depthPyramidBuilt ? depthPyramidLevels : 0;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &cullDescriptorSets[imageIndex], 0, NULL);
+    vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+    vkCmdDispatch(commandBuffer, (drawCount + 63) / 64, 1, 1);
+
+    //Read by the draws, by the late phase and by the host once the fence was waited on
+    VkBufferMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = indirectBuffers[imageIndex];
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 0, NULL, 1, &barrier, 0, NULL);
+}
+
+//One dispatch per level, each waits for the level before. Only the rendered area of the depth buffer is reduced
+void recordDepthPyramid(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidPipeline);
+
+    int32_t sourceLast[2] = {int32_t(renderExtent.width) - 1, int32_t(renderExtent.height) - 1};
+    for (uint32_t level = 0; level < depthPyramidLevels; level++)
+    {
+        int32_t levelWidth = std::max(1u, depthPyramidExtent.width >> level);
+        int32_t levelHeight = std::max(1u, depthPyramidExtent.height >> level);
+        int32_t destinationLast[2] = {std::min(sourceLast[0] >> 1, levelWidth - 1), std::min(sourceLast[1] >> 1, levelHeight - 1)};
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidPipelineLayout, 0, 1,
+                                &depthPyramidDescriptorSets[level], 0, NULL);
+        vkCmdPushConstants(commandBuffer, depthPyramidPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(sourceLast), sourceLast);
+        vkCmdDispatch(commandBuffer, destinationLast[0] / 8 + 1, destinationLast[1] / 8 + 1, 1);
+        sourceLast[0] = destinationLast[0];
+        sourceLast[1] = destinationLast[1];
+
+        if (level + 1 == depthPyramidLevels)
+            break;
+
+        VkImageMemoryBarrier barrier;
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.pNext = NULL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = depthPyramidImage;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = level;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 0, NULL, 0, NULL, 1, &barrier);
+    }
+
+    depthPyramidBuilt = true;
+    depthPyramidViewport = renderExtent;
+}
+
+//Draws what the early phase culled but the pyramid of this frame shows, on top of the early draws
+void recordLatePass(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    VkRenderPassBeginInfo renderPassBeginInfo;
+    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext = NULL;
+    renderPassBeginInfo.renderPass = lateRenderPass;
+    renderPassBeginInfo.framebuffer = framebuffers[imageIndex];
+    renderPassBeginInfo.renderArea.offset = {0, 0};
+    renderPassBeginInfo.renderArea.extent = renderExtent;
+    renderPassBeginInfo.clearValueCount = 0;
+    renderPassBeginInfo.pClearValues = NULL;
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    recordDraws(commandBuffer, imageIndex, false, true);
+
+    vkCmdEndRenderPass(commandBuffer);
+}
+
+//Ends the GPU time in front of the upscale, which has to wait for the swapchain image
+void recordSceneEndTimestamp(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    if (timestampQueryPool != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, imageIndex * 2 + 1);
+}
+
+//Scales the scene up to the swapchain image
+void recordUpscalePass(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    VkImageBlit blit;
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel = 0;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[0] = {0, 0, 0};
+    blit.srcOffsets[1] = {int32_t(renderExtent.width), int32_t(renderExtent.height), 1};
+    blit.dstSubresource = blit.srcSubresource;
+    blit.dstOffsets[0] = {0, 0, 0};
+    blit.dstOffsets[1] = {int32_t(width), int32_t(height), 1};
+
+    vkCmdBlitImage(commandBuffer, renderGraphGetImage(renderGraph, sceneColorResource), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   swapchainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+}
+
+//Every pass declares what it reads and writes, the graph places the barriers in between
+void createRenderGraph()
+{
+    //The swapchain image is first touched by the blit with dynamic resolution, else by the main pass
+    backbufferWaitStage = useDynamicResolution ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    //Headless images end up as if they were read back
+    VkImageLayout backbufferFinalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    backbufferResource = renderGraphImportImage(renderGraph, "backbuffer", VK_IMAGE_ASPECT_COLOR_BIT,
+                                                VK_IMAGE_LAYOUT_UNDEFINED, backbufferFinalLayout, backbufferWaitStage);
+
+    VkExtent2D targetExtent = getRenderTargetExtent();
+    depthResource = renderGraphCreateImage(renderGraph, "depth", depthFormat, targetExtent, VK_IMAGE_ASPECT_DEPTH_BIT);
+    uint32_t colorResource = backbufferResource;
+    if (useDynamicResolution)
+    {
+        sceneColorResource = renderGraphCreateImage(renderGraph, "sceneColor", ourFormat, targetExtent, VK_IMAGE_ASPECT_COLOR_BIT);
+        colorResource = sceneColorResource;
+    }
+
+    if (useOcclusionCulling)
+    {
+        //Written at the end of a frame and read at the start of the next one
+        createDepthPyramid(targetExtent);
+        depthPyramidResource = renderGraphImportImage(renderGraph, "depthPyramid", VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL,
+                                                      VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+        renderGraphSetImportedImage(renderGraph, depthPyramidResource, depthPyramidImage, depthPyramidView);
+        renderGraphMarkOutput(renderGraph, depthPyramidResource);
+        renderGraphAddPass(renderGraph, "earlyCull", {{depthPyramidResource, RG_USAGE_STORAGE_READ}}, [](VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+            recordCull(commandBuffer, imageIndex, false);
+        }, true);
+    }
+
+    if (useDepthPrepass)
+    {
+        renderGraphAddPass(renderGraph, "depthPrepass", {{depthResource, RG_USAGE_DEPTH_ATTACHMENT_WRITE}}, recordDepthPrepass);
+        renderGraphAddPass(renderGraph, "main", {{colorResource, RG_USAGE_COLOR_ATTACHMENT_WRITE}, {depthResource, RG_USAGE_DEPTH_ATTACHMENT_READ}}, recordMainPass);
+    }
+    else
+    {
+        renderGraphAddPass(renderGraph, "main", {{colorResource, RG_USAGE_COLOR_ATTACHMENT_WRITE}, {depthResource, RG_USAGE_DEPTH_ATTACHMENT_WRITE}}, recordMainPass);
+    }
+
+    if (useOcclusionCulling)
+    {
+        renderGraphAddPass(renderGraph, "depthPyramid", {{depthResource, RG_USAGE_SAMPLED_READ}, {depthPyramidResource, RG_USAGE_STORAGE_WRITE}}, recordDepthPyramid);
+        renderGraphAddPass(renderGraph, "lateCull", {{depthPyramidResource, RG_USAGE_STORAGE_READ}}, [](VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+            recordCull(commandBuffer, imageIndex, true);
+        }, true);
+        renderGraphAddPass(renderGraph, "late", {{colorResource, RG_USAGE_COLOR_ATTACHMENT_WRITE}, {depthResource, RG_USAGE_DEPTH_ATTACHMENT_WRITE}}, recordLatePass);
+        //Built again with the late draws, they are occluders for the early phase of the next frame as well
+        renderGraphAddPass(renderGraph, "finalDepthPyramid", {{depthResource, RG_USAGE_SAMPLED_READ}, {depthPyramidResource, RG_USAGE_STORAGE_WRITE}}, recordDepthPyramid);
+    }
+
+    if (useDynamicResolution)
+    {
+        renderGraphAddPass(renderGraph, "sceneEnd", {}, recordSceneEndTimestamp, true);
+        renderGraphAddPass(renderGraph, "upscale", {{sceneColorResource, RG_USAGE_TRANSFER_SRC}, {backbufferResource, RG_USAGE_TRANSFER_DST}}, recordUpscalePass);
+    }
+
+    renderGraphMarkOutput(renderGraph, backbufferResource);
+    compileRenderGraph(renderGraph, physicalDevice, device);
+    if (useOcclusionCulling)
+        writeDepthPyramidDescriptors(renderGraphGetImageView(renderGraph, depthResource));
+}
+
+void destroyRenderGraphAndPyramid()
+{
+    destroyRenderGraph(renderGraph, device);
+    if (useOcclusionCulling)
+        destroyDepthPyramid();
+}
+
+//A new pyramid starts out undefined, the render graph expects it in the general layout
+void recordDepthPyramidInitialization(VkCommandBuffer commandBuffer)
+{
+    VkImageMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = depthPyramidImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, NULL, 0, NULL, 1, &barrier);
+    depthPyramidInitialized = true;
+}
+
+void recordCommandBuffer(uint32_t imageIndex)
+{
+    VkCommandBufferBeginInfo commandBufferBeginInfo;
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.pNext = NULL;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBufferBeginInfo.pInheritanceInfo = NULL;
+    VkResult result = vkBeginCommandBuffer(commandBuffers[imageIndex], &commandBufferBeginInfo);
+    ASSERT_VULKAN(result);
+
+    if (timestampQueryPool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffers[imageIndex], timestampQueryPool, imageIndex * 2, 2);
+        vkCmdWriteTimestamp(commandBuffers[imageIndex], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, imageIndex * 2);
+    }
+
+    if (useOcclusionCulling && !depthPyramidInitialized)
+        recordDepthPyramidInitialization(commandBuffers[imageIndex]);
+
+    renderGraphSetImportedImage(renderGraph, backbufferResource, swapchainImages[imageIndex], imageViews[imageIndex]);
+    recordRenderGraph(renderGraph, commandBuffers[imageIndex], imageIndex);
+
+    if (useDynamicResolution)
+    {
+        timestampsWritten[imageIndex] = timestampQueryPool != VK_NULL_HANDLE;
+        frameRenderScales[imageIndex] = getDynamicResolutionRenderScale(dynamicResolution);
+    }
+
+    result = vkEndCommandBuffer(commandBuffers[imageIndex]);
+    ASSERT_VULKAN(result);
+}
+
+void createSemaphores()
+{
+    VkSemaphoreCreateInfo semaphoreCreateInfo;
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = NULL;
+    semaphoreCreateInfo.flags = 0;
+
+    VkResult result = vkCreateSemaphore(device, &semaphoreCreateInfo, NULL, &semaphoreImageAvailable);
+    ASSERT_VULKAN(result);
+    result = vkCreateSemaphore(device, &semaphoreCreateInfo, NULL, &semaphoreRenderingDone);
+    ASSERT_VULKAN(result);
+}
+
+//Startup as a dependency graph, a step starts as soon as the steps it needs are done:
+//  step                                                needs
+//  instance, shaderFiles, meshFile                    -
+//  window (main thread)                                -
+//  device                                              instance
+//  surface                                             window, instance
+//  renderPass, pipelineCache, commandPool, semaphores  device
+//  shaderModules                                       shaderFiles, device
+//  pipelines                                           shaderModules, pipelineCache, renderPass
+//  cullPipelines (occlusion culling only)              shaderModules, pipelineCache
+//  swapchain                                           device, surface
+//  renderGraph                                         renderPass, cullPipelines
+//  framebuffers                                        swapchain, renderGraph
+//  commandBuffers                                      commandPool, swapchain
+//  meshBuffers                                         meshFile, device
+void startVulkan()
+{
+    if (headless)
+        startupStart = std::chrono::steady_clock::now();
+
+    TaskGraph startup;
+    uint32_t instanceTask = taskGraphAdd(startup, "instance", createInstance);
+    uint32_t shaderFilesTask = taskGraphAdd(startup, "shaderFiles", loadShaders);
+    uint32_t meshFileTask = taskGraphAdd(startup, "meshFile", loadSceneMesh);
+    uint32_t deviceTask = taskGraphAdd(startup, "device", []() {
+        pickPhysicalDevice();
+        createLogicalDevice();
+        createQueue();
+    }, {instanceTask});
+
+    std::vector<uint32_t> swapchainDependencies = {deviceTask};
+    if (!headless)
+    {
+        uint32_t windowTask = taskGraphAdd(startup, "window", createWindow, {}, true);
+        uint32_t surfaceTask = taskGraphAdd(startup, "surface", createGlfwWindowSurface, {windowTask, instanceTask});
+        swapchainDependencies.push_back(surfaceTask);
+    }
+    if (printDiagnostics)
+    {
+        taskGraphAdd(startup, "diagnostics", []() {
+            printInstanceLayers();
+            printInstanceExtensions();
+            printStatsOfAllPhysicalDevices();
+        }, swapchainDependencies);
+    }
+
+    uint32_t swapchainTask = taskGraphAdd(startup, "swapchain", []() {
+        if (!headless)
+            checkSurfaceSupport();
+        createSwapchain();
+        createImageViews();
+    }, swapchainDependencies);
+    uint32_t shaderModulesTask = taskGraphAdd(startup, "shaderModules", createShaderModules, {shaderFilesTask, deviceTask});
+    uint32_t pipelineCacheTask = taskGraphAdd(startup, "pipelineCache", createPipelineCache, {deviceTask});
+    uint32_t renderPassTask = taskGraphAdd(startup, "renderPass", createRenderPass, {deviceTask});
+    taskGraphAdd(startup, "pipelines", createPipeline, {shaderModulesTask, pipelineCacheTask, renderPassTask});
+    //The depth pyramid of the render graph allocates its descriptor sets with the layout of the cull pipelines
+    std::vector<uint32_t> renderGraphDependencies = {renderPassTask};
+    if (useOcclusionCulling)
+        renderGraphDependencies.push_back(taskGraphAdd(startup, "cullPipelines", createOcclusionCullingPipelines, {shaderModulesTask, pipelineCacheTask}));
+    uint32_t renderGraphTask = taskGraphAdd(startup, "renderGraph", createRenderGraph, renderGraphDependencies);
+    taskGraphAdd(startup, "framebuffers", createFramebuffers, {swapchainTask, renderGraphTask});
+    uint32_t commandPoolTask = taskGraphAdd(startup, "commandPool", createCommandPool, {deviceTask});
+    taskGraphAdd(startup, "commandBuffers", []() {
+        createCommandBuffers();
+        createFences();
+        createTimestampQueries();
+    }, {commandPoolTask, swapchainTask});
+    taskGraphAdd(startup, "semaphores", createSemaphores, {deviceTask});
+    taskGraphAdd(startup, "meshBuffers", createMeshBuffers, {meshFileTask, deviceTask});
+
+    //Most of the tasks wait for the driver or the disk, so more threads than cores still pay off
+    uint32_t amountOfWorkers = std::max(3u, std::thread::hardware_concurrency());
+    runTaskGraph(startup, amountOfWorkers);
+
+    if (printDiagnostics)
+    {
+        diagnosticLog << "Startup tasks:\n";
+        printTaskGraphTimeline(startup, diagnosticLog);
+        printRenderGraphStats(renderGraph, diagnosticLog);
+    }
+}
+
+//Called once the first frame was presented
+void reportStartup()
+{
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+    if (printDiagnostics)
+    {
+        std::cout << diagnosticLog.str();
+        diagnosticLog.str("");
+    }
+    std::cout << "Time to first frame: " << milliseconds << " ms" << std::endl;
+}
+
+void recreateSwapchain()
+{
+    vkDeviceWaitIdle(device);
+    swapchainOutOfDate = false;
+
+    destroyTimestampQueries();
+    destroyFences();
+    vkFreeCommandBuffers(device, commandPool, amountOfImagesInSwapchain, commandBuffers.data());
+    vkDestroyCommandPool(device, commandPool, NULL);
+    destroyFramebuffers();
+    destroyRenderGraphAndPyramid();
+
+    vkDestroyPipeline(device, pipeline, NULL);
+    vkDestroyRenderPass(device, renderPass, NULL);
+    if (useOcclusionCulling)
+    {
+        if (useDepthPrepass)
+            vkDestroyPipeline(device, latePipeline, NULL);
+        vkDestroyRenderPass(device, lateRenderPass, NULL);
+    }
+    if (useDepthPrepass)
+    {
+        vkDestroyPipeline(device, depthPrepassPipeline, NULL);
+        vkDestroyRenderPass(device, depthPrepassRenderPass, NULL);
+    }
+    for (int i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        vkDestroyImageView(device, imageViews.data()[i], NULL);
+    }
+    vkDestroyPipelineLayout(device, pipelineLayout, NULL);
+
+    VkSwapchainKHR oldSwapchain = swapchain;
+    if (headless)
+        destroyHeadlessImages();
+
+    createSwapchain();
+    createImageViews();
+    createRenderPass();
+    createPipeline();
+    createRenderGraph();
+    createFramebuffers();
+    createCommandPool();
+    createCommandBuffers();
+    createFences();
+    createTimestampQueries();
+    if (!headless)
+        vkDestroySwapchainKHR(device, oldSwapchain, NULL);
+}
+
+//Only the scene targets depend on the scale, the swapchain stays as it is
+void reallocateRenderTargets()
+{
+    vkDeviceWaitIdle(device);
+    destroyFramebuffers();
+    destroyRenderGraphAndPyramid();
+    createRenderGraph();
+    createFramebuffers();
+}
+
+//Feeds the GPU time of the last frame recorded into this command buffer to the controller
+void updateRenderScale(uint32_t imageIndex)
+{
+    if (!useDynamicResolution)
+    {
+        renderExtent = {width, height};
+        return;
+    }
+
+    if (timestampsWritten[imageIndex])
+    {
+        uint64_t timestamps[2];
+        VkResult result = vkGetQueryPoolResults(device, timestampQueryPool, imageIndex * 2, 2, sizeof(timestamps), timestamps,
+                                                sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS)
+        {
+            uint64_t ticks = (timestamps[1] - timestamps[0]) & timestampMask;
+            lastFrameTimings.gpuMs = ticks * timestampPeriod / 1000000.0;
+            updateDynamicResolution(dynamicResolution, lastFrameTimings.gpuMs, frameRenderScales[imageIndex]);
+            if (dynamicResolutionNeedsReallocation(dynamicResolution))
+                reallocateRenderTargets();
+        }
+    }
+
+    renderExtent = getScaledExtent(getDynamicResolutionRenderScale(dynamicResolution));
+}
+
+void drawFrame()
+{
+    uint32_t imageIndex;
+    VkResult result;
+    if (headless)
+    {
+        imageIndex = headlessFrame++ % amountOfImagesInSwapchain;
+    }
+    else
+    {
+        result = vkAcquireNextImageKHR(device, swapchain, std::numeric_limits<uint64_t>::max(), semaphoreImageAvailable, NULL, &imageIndex);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            swapchainOutOfDate = true;
+            return;
+        }
+    }
+
+    //The command buffer of this image may still be in flight
+    result = vkWaitForFences(device, 1, &commandBufferFences[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    ASSERT_VULKAN(result);
+    vkResetFences(device, 1, &commandBufferFences[imageIndex]);
+    updateRenderScale(imageIndex);
+
+    auto recordStart = std::chrono::steady_clock::now();
+    buildDrawList();
+    uploadTransforms(imageIndex);
+    if (useOcclusionCulling)
+        uploadCullDraws(imageIndex);
+    recordCommandBuffer(imageIndex);
+    auto recordEnd = std::chrono::steady_clock::now();
+
+    //Headless frames are not presented, so there is nothing to wait for or to signal
+    VkSubmitInfo submitInfo;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = NULL;
+    submitInfo.waitSemaphoreCount = headless ? 0 : 1;
+    submitInfo.pWaitSemaphores = &semaphoreImageAvailable;
+    VkPipelineStageFlags waitStageMask[] = {
+        backbufferWaitStage
+        //VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+    };
+    submitInfo.pWaitDstStageMask = waitStageMask;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+    submitInfo.signalSemaphoreCount = headless ? 0 : 1;
+    submitInfo.pSignalSemaphores = &semaphoreRenderingDone;
+
+    result = vkQueueSubmit(queue, 1, &submitInfo, commandBufferFences[imageIndex]);
+    ASSERT_VULKAN(result);
+    auto submitEnd = std::chrono::steady_clock::now();
+
+    lastFrameTimings.recordMs = std::chrono::duration<double, std::milli>(recordEnd - recordStart).count();
+    lastFrameTimings.submitMs = std::chrono::duration<double, std::milli>(submitEnd - recordEnd).count();
+    if (headless)
+        return;
+
+    VkPresentInfoKHR presentInfo;
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.pNext = NULL;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &semaphoreRenderingDone;
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = &swapchain;
+    presentInfo.pImageIndices = &imageIndex;
+    presentInfo.pResults = NULL;
+
+    result = vkQueuePresentKHR(queue, &presentInfo);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+        swapchainOutOfDate = true;
+    else
+        ASSERT_VULKAN(result);
+    //vkQueueWaitIdle(queue);
+}
+
+//The window size of an event can already be outdated, the surface knows the current one
+void resizeSwapchain()
+{
+    VkSurfaceCapabilitiesKHR surfaceCapabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &surfaceCapabilities);
+
+    uint32_t w = requestedWidth;
+    uint32_t h = requestedHeight;
+    if (surfaceCapabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+    {
+        w = surfaceCapabilities.currentExtent.width;
+        h = surfaceCapabilities.currentExtent.height;
+    }
+    if (w > surfaceCapabilities.maxImageExtent.width)
+        w = surfaceCapabilities.maxImageExtent.width;
+    if (h > surfaceCapabilities.maxImageExtent.height)
+        h = surfaceCapabilities.maxImageExtent.height;
+
+    //Minimized, nothing to draw until the window comes back
+    windowMinimized = w == 0 || h == 0;
+    if (windowMinimized)
+        return;
+
+    width = w;
+    height = h;
+    recreateSwapchain();
+}
+
+//Drains the events of the main thread. Many resizes while dragging the window edge only recreate the swapchain once
+void processWindowEvents()
+{
+    bool resized = false;
+    WindowEvent event;
+    while (spscQueuePop(windowEvents, event))
+    {
+        if (event.type == WINDOW_EVENT_RESIZE)
+        {
+            requestedWidth = event.width;
+            requestedHeight = event.height;
+            resized = true;
+        }
+        else if (event.type == WINDOW_EVENT_CURSOR && width > 0 && height > 0)
+        {
+            cursorOffset[0] = float(event.x / width * 2.0 - 1.0) * 0.5f;
+            cursorOffset[1] = float(event.y / height * 2.0 - 1.0) * 0.5f;
+        }
+    }
+
+    if (resized || swapchainOutOfDate)
+        resizeSwapchain();
+}
+
+//Owns all Vulkan work after startup
+void renderLoop()
+{
+    requestedWidth = width;
+    requestedHeight = height;
+    bool firstFrame = true;
+
+    while (renderThreadRunning.load(std::memory_order_acquire))
+    {
+        processWindowEvents();
+        if (windowMinimized)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        simulationState = tripleBufferRead(simulationSnapshots);
+        drawFrame();
+
+        if (firstFrame)
+        {
+            reportStartup();
+            firstFrame = false;
+        }
+    }
+
+    vkDeviceWaitIdle(device);
+}
+
+//The main thread only handles the window and input and steps the simulation, it never waits for the GPU
+void startGameLoop()
+{
+    renderThreadRunning = true;
+    std::thread renderThread(renderLoop);
+
+    double simulationStart = glfwGetTime();
+    while (!glfwWindowShouldClose(window))
+    {
+        glfwWaitEventsTimeout(simulationStep);
+        flushWindowEvents();
+
+        SimulationState &state = tripleBufferBack(simulationSnapshots);
+        state.time = glfwGetTime() - simulationStart;
+        tripleBufferPublish(simulationSnapshots);
+    }
+
+    renderThreadRunning = false;
+    renderThread.join();
+}
+
+void shutdownVulkan()
+{
+    //Cleanup Vulkan
+    vkDeviceWaitIdle(device);
+
+    vkDestroySemaphore(device, semaphoreImageAvailable, NULL);
+    vkDestroySemaphore(device, semaphoreRenderingDone, NULL);
+    destroyMeshBuffers();
+    destroyTransformBuffers();
+    destroyCullBuffers();
+    destroyTimestampQueries();
+    destroyFences();
+    vkFreeCommandBuffers(device, commandPool, amountOfImagesInSwapchain, commandBuffers.data());
+    vkDestroyCommandPool(device, commandPool, NULL);
+    destroyFramebuffers();
+    destroyRenderGraphAndPyramid();
+
+    vkDestroyPipeline(device, pipeline, NULL);
+    vkDestroyRenderPass(device, renderPass, NULL);
+    if (useOcclusionCulling)
+    {
+        if (useDepthPrepass)
+            vkDestroyPipeline(device, latePipeline, NULL);
+        vkDestroyRenderPass(device, lateRenderPass, NULL);
+    }
+    if (useDepthPrepass)
+    {
+        vkDestroyPipeline(device, depthPrepassPipeline, NULL);
+        vkDestroyRenderPass(device, depthPrepassRenderPass, NULL);
+    }
+    for (int i = 0; i < amountOfImagesInSwapchain; i++)
+    {
+        vkDestroyImageView(device, imageViews.data()[i], NULL);
+    }
+    vkDestroyPipelineLayout(device, pipelineLayout, NULL);
+    vkDestroyShaderModule(device, shaderModuleVert, NULL);
+    vkDestroyShaderModule(device, shaderModuleFrag, NULL);
+    if (useOcclusionCulling)
+        destroyOcclusionCullingPipelines();
+    vkDestroyPipelineCache(device, pipelineCache, NULL);
+    if (headless)
+    {
+        destroyHeadlessImages();
+    }
+    else
+    {
+        vkDestroySwapchainKHR(device, swapchain, NULL);
+    }
+    vkDestroyDevice(device, NULL);
+    if (!headless)
+        vkDestroySurfaceKHR(instance, surface, NULL);
+    vkDestroyInstance(instance, NULL);
+}
+
+void shutdownGLFW()
+{
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
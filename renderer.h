@@ -0,0 +1,44 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <cstdint>
+#include "dynamicResolution.h"
+
+//Settings, have to be set before startVulkan
+extern bool headless; //Renders into plain images instead of a window swapchain, nothing is presented
+extern bool useValidationLayers;
+extern bool printDiagnostics; //Dumps layers, extensions, devices and startup task timings after the first frame
+extern bool useDepthPrepass;
+extern uint32_t sceneDrawCount;
+extern const char *meshFilename; //.obj or .glb drawn by every draw, NULL draws a triangle
+extern float lodPixelError; //Screen space error in pixels a draw may pick its level of detail with, 0 always draws the full mesh
+extern uint32_t width, height;
+extern bool useDynamicResolution; //Renders the scene at a scale picked from the GPU time and blits it up to the swapchain
+extern DynamicResolution dynamicResolution; //Bounds and target frame time can be changed before startVulkan
+extern bool useOcclusionCulling; //Culls hidden draws on the GPU against a depth pyramid, in two phases
+
+//CPU time and load of the last drawFrame call
+struct FrameTimings
+{
+    double recordMs = 0.0;
+    double submitMs = 0.0;
+    double gpuMs = 0.0; //Scene passes without the upscale, only measured with dynamic resolution. Lags a few frames behind
+    uint32_t triangleCount = 0; //After the level of detail selection
+    uint32_t culledDraws = 0; //Outside the frustum or hidden, with occlusion culling. Lags a few frames behind
+};
+extern FrameTimings lastFrameTimings;
+
+extern VkDevice device;
+extern VkQueue queue;
+extern VkRenderPass renderPass;
+extern VkPipelineCache pipelineCache;
+
+void startGLFW();
+void startVulkan();
+void recreateSwapchain();
+void drawFrame();
+void startGameLoop();
+void shutdownVulkan();
+void shutdownGLFW();
+
+VkPipeline createGraphicsPipeline(VkRenderPass pass, bool depthOnly, VkCompareOp depthCompareOp, VkBool32 depthWriteEnable);
@@ -0,0 +1,424 @@
+#include "scene.h"
+#include "taskGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+//Smaller partitions cost more in scheduling than they gain in parallelism
+const uint32_t minNodesPerPartition = 4096;
+const uint32_t maxPartitions = 64;
+//Pieces handed out to the partitions are at most this much smaller than a partition, so they can be balanced
+const uint32_t piecesPerPartition = 4;
+
+uint32_t sceneAddNode(SceneStore &scene, uint32_t parentId, const Transform &local, const float bounds[4])
+{
+    uint32_t id = scene.slots.size();
+    uint32_t slot = scene.parents.size();
+    scene.slots.push_back(slot);
+    scene.nodeIds.push_back(id);
+    scene.parents.push_back(parentId == SCENE_NO_PARENT ? SCENE_NO_PARENT : scene.slots[parentId]);
+
+    scene.positionX.push_back(local.position[0]);
+    scene.positionY.push_back(local.position[1]);
+    scene.positionZ.push_back(local.position[2]);
+    scene.rotationX.push_back(local.rotation[0]);
+    scene.rotationY.push_back(local.rotation[1]);
+    scene.rotationZ.push_back(local.rotation[2]);
+    scene.rotationW.push_back(local.rotation[3]);
+    scene.scaleX.push_back(local.scale[0]);
+    scene.scaleY.push_back(local.scale[1]);
+    scene.scaleZ.push_back(local.scale[2]);
+
+    scene.boundsX.push_back(bounds[0]);
+    scene.boundsY.push_back(bounds[1]);
+    scene.boundsZ.push_back(bounds[2]);
+    scene.boundsRadius.push_back(bounds[3]);
+
+    scene.localMatrices.emplace_back();
+    scene.worldMatrices.emplace_back();
+    scene.worldBoundsX.push_back(0.f);
+    scene.worldBoundsY.push_back(0.f);
+    scene.worldBoundsZ.push_back(0.f);
+    scene.worldBoundsRadius.push_back(0.f);
+
+    scene.dirty.push_back(1);
+    scene.changedVersions.push_back(0);
+    scene.sorted = false;
+    return id;
+}
+
+void sceneClear(SceneStore &scene)
+{
+    uint32_t version = scene.version;
+    std::unique_ptr<WorkerPool> workerPool = std::move(scene.workerPool);
+    scene = SceneStore();
+    //Keeps the versions of per frame buffers valid
+    scene.version = version;
+    scene.workerPool = std::move(workerPool);
+}
+
+void sceneSetLocalTransform(SceneStore &scene, uint32_t id, const Transform &local)
+{
+    uint32_t slot = scene.slots[id];
+    scene.positionX[slot] = local.position[0];
+    scene.positionY[slot] = local.position[1];
+    scene.positionZ[slot] = local.position[2];
+    scene.rotationX[slot] = local.rotation[0];
+    scene.rotationY[slot] = local.rotation[1];
+    scene.rotationZ[slot] = local.rotation[2];
+    scene.rotationW[slot] = local.rotation[3];
+    scene.scaleX[slot] = local.scale[0];
+    scene.scaleY[slot] = local.scale[1];
+    scene.scaleZ[slot] = local.scale[2];
+    scene.dirty[slot] = 1;
+}
+
+template <typename T>
+static void permute(std::vector<T> &values, const std::vector<uint32_t> &order)
+{
+    std::vector<T> permuted(values.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        permuted[i] = values[order[i]];
+    }
+    values.swap(permuted);
+}
+
+//The scene is cut into pieces: a subtree that fits into a piece stays whole, the root of a bigger one becomes a
+//shared ancestor and its children are cut the same way. Pieces are handed out biggest first into the smallest
+//partition. The shared ancestors come first, then the partitions, each ordered by depth
+static void sortScene(SceneStore &scene)
+{
+    const uint32_t count = sceneGetNodeCount(scene);
+
+    //Parents always come before their children, so one pass finds the depths and one backwards pass the
+    //subtree sizes
+    std::vector<uint32_t> depths(count);
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        uint32_t parent = scene.parents[slot];
+        depths[slot] = parent == SCENE_NO_PARENT ? 0 : depths[parent] + 1;
+    }
+    std::vector<uint32_t> subtreeSizes(count, 1);
+    for (uint32_t slot = count; slot-- > 0;)
+    {
+        if (scene.parents[slot] != SCENE_NO_PARENT)
+            subtreeSizes[scene.parents[slot]] += subtreeSizes[slot];
+    }
+
+    uint32_t amountOfPartitions = std::min(std::max(count / minNodesPerPartition, 1u), maxPartitions);
+    uint32_t maxPieceSize = amountOfPartitions == 1 ? count : std::max(count / (amountOfPartitions * piecesPerPartition), 1u);
+
+    //Root of the piece of every node, SCENE_NO_PARENT for the shared ancestors
+    std::vector<uint32_t> pieces(count);
+    std::vector<uint32_t> pieceRoots;
+    uint32_t sharedCount = 0;
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        uint32_t parent = scene.parents[slot];
+        if (parent != SCENE_NO_PARENT && pieces[parent] != SCENE_NO_PARENT)
+        {
+            pieces[slot] = pieces[parent];
+        }
+        else if (subtreeSizes[slot] > maxPieceSize)
+        {
+            pieces[slot] = SCENE_NO_PARENT;
+            sharedCount++;
+        }
+        else
+        {
+            pieces[slot] = slot;
+            pieceRoots.push_back(slot);
+        }
+    }
+    std::stable_sort(pieceRoots.begin(), pieceRoots.end(), [&](uint32_t a, uint32_t b) { return subtreeSizes[a] > subtreeSizes[b]; });
+
+    amountOfPartitions = std::min(amountOfPartitions, std::max(uint32_t(pieceRoots.size()), 1u));
+    std::vector<uint32_t> partitionSizes(amountOfPartitions, 0);
+    std::vector<uint32_t> piecePartitions(count, 0);
+    for (uint32_t piece : pieceRoots)
+    {
+        uint32_t smallest = std::min_element(partitionSizes.begin(), partitionSizes.end()) - partitionSizes.begin();
+        piecePartitions[piece] = smallest;
+        partitionSizes[smallest] += subtreeSizes[piece];
+    }
+
+    //New order: shared ancestors, partition, then depth, then the old order
+    std::vector<uint32_t> order(count);
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        order[slot] = slot;
+    }
+    auto getGroup = [&](uint32_t slot) { return pieces[slot] == SCENE_NO_PARENT ? 0 : piecePartitions[pieces[slot]] + 1; };
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        uint32_t groupA = getGroup(a);
+        uint32_t groupB = getGroup(b);
+        if (groupA != groupB)
+            return groupA < groupB;
+        return depths[a] < depths[b];
+    });
+
+    std::vector<uint32_t> newSlots(count);
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        newSlots[order[slot]] = slot;
+    }
+    for (uint32_t &parent : scene.parents)
+    {
+        if (parent != SCENE_NO_PARENT)
+            parent = newSlots[parent];
+    }
+
+    permute(scene.parents, order);
+    permute(scene.positionX, order);
+    permute(scene.positionY, order);
+    permute(scene.positionZ, order);
+    permute(scene.rotationX, order);
+    permute(scene.rotationY, order);
+    permute(scene.rotationZ, order);
+    permute(scene.rotationW, order);
+    permute(scene.scaleX, order);
+    permute(scene.scaleY, order);
+    permute(scene.scaleZ, order);
+    permute(scene.boundsX, order);
+    permute(scene.boundsY, order);
+    permute(scene.boundsZ, order);
+    permute(scene.boundsRadius, order);
+    permute(scene.nodeIds, order);
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        scene.slots[scene.nodeIds[slot]] = slot;
+    }
+
+    scene.sharedEnd = sharedCount;
+    scene.partitions.clear();
+    uint32_t begin = sharedCount;
+    for (uint32_t size : partitionSizes)
+    {
+        scene.partitions.push_back({begin, begin + size});
+        begin += size;
+    }
+
+    //Every slot moved, so every node is recomputed and uploaded again
+    std::fill(scene.dirty.begin(), scene.dirty.end(), 1);
+    scene.sorted = true;
+}
+
+void composeMatrix(const Transform &transform, Matrix4 &out)
+{
+    float x = transform.rotation[0], y = transform.rotation[1], z = transform.rotation[2], w = transform.rotation[3];
+    const float *scale = transform.scale;
+    float *m = out.m;
+
+    m[0] = (1.f - 2.f * (y * y + z * z)) * scale[0];
+    m[1] = 2.f * (x * y + w * z) * scale[0];
+    m[2] = 2.f * (x * z - w * y) * scale[0];
+    m[3] = 0.f;
+    m[4] = 2.f * (x * y - w * z) * scale[1];
+    m[5] = (1.f - 2.f * (x * x + z * z)) * scale[1];
+    m[6] = 2.f * (y * z + w * x) * scale[1];
+    m[7] = 0.f;
+    m[8] = 2.f * (x * z + w * y) * scale[2];
+    m[9] = 2.f * (y * z - w * x) * scale[2];
+    m[10] = (1.f - 2.f * (x * x + y * y)) * scale[2];
+    m[11] = 0.f;
+    m[12] = transform.position[0];
+    m[13] = transform.position[1];
+    m[14] = transform.position[2];
+    m[15] = 1.f;
+}
+
+//Same as composeMatrix for four neighbouring slots, one node per SSE lane. The columns are transposed
+//back into one matrix per node at the end
+static void composeMatrices4(SceneStore &scene, uint32_t slot)
+{
+    __m128 x = _mm_loadu_ps(&scene.rotationX[slot]);
+    __m128 y = _mm_loadu_ps(&scene.rotationY[slot]);
+    __m128 z = _mm_loadu_ps(&scene.rotationZ[slot]);
+    __m128 w = _mm_loadu_ps(&scene.rotationW[slot]);
+    __m128 scaleX = _mm_loadu_ps(&scene.scaleX[slot]);
+    __m128 scaleY = _mm_loadu_ps(&scene.scaleY[slot]);
+    __m128 scaleZ = _mm_loadu_ps(&scene.scaleZ[slot]);
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+    __m128 columns[4][4];
+    columns[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX);
+    columns[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scaleX);
+    columns[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scaleX);
+    columns[0][3] = _mm_setzero_ps();
+    columns[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scaleY);
+    columns[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY);
+    columns[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scaleY);
+    columns[1][3] = _mm_setzero_ps();
+    columns[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scaleZ);
+    columns[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scaleZ);
+    columns[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ);
+    columns[2][3] = _mm_setzero_ps();
+    columns[3][0] = _mm_loadu_ps(&scene.positionX[slot]);
+    columns[3][1] = _mm_loadu_ps(&scene.positionY[slot]);
+    columns[3][2] = _mm_loadu_ps(&scene.positionZ[slot]);
+    columns[3][3] = one;
+
+    Matrix4 *out = &scene.localMatrices[slot];
+    for (uint32_t column = 0; column < 4; column++)
+    {
+        __m128 *c = columns[column];
+        _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+        _mm_store_ps(out[0].m + column * 4, c[0]);
+        _mm_store_ps(out[1].m + column * 4, c[1]);
+        _mm_store_ps(out[2].m + column * 4, c[2]);
+        _mm_store_ps(out[3].m + column * 4, c[3]);
+    }
+}
+
+void multiplyMatrices(const Matrix4 &a, const Matrix4 &b, Matrix4 &out)
+{
+#if defined(__AVX__)
+    //Two columns of the result per instruction, both halves hold the same column of a
+    __m256 a0 = _mm256_broadcast_ps((const __m128 *)(a.m + 0));
+    __m256 a1 = _mm256_broadcast_ps((const __m128 *)(a.m + 4));
+    __m256 a2 = _mm256_broadcast_ps((const __m128 *)(a.m + 8));
+    __m256 a3 = _mm256_broadcast_ps((const __m128 *)(a.m + 12));
+    for (uint32_t column = 0; column < 4; column += 2)
+    {
+        __m256 bColumns = _mm256_loadu_ps(b.m + column * 4);
+        __m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(bColumns, 0x00));
+        result = _mm256_add_ps(result, _mm256_mul_ps(a1, _mm256_permute_ps(bColumns, 0x55)));
+        result = _mm256_add_ps(result, _mm256_mul_ps(a2, _mm256_permute_ps(bColumns, 0xAA)));
+        result = _mm256_add_ps(result, _mm256_mul_ps(a3, _mm256_permute_ps(bColumns, 0xFF)));
+        _mm256_storeu_ps(out.m + column * 4, result);
+    }
+#else
+    __m128 a0 = _mm_load_ps(a.m + 0);
+    __m128 a1 = _mm_load_ps(a.m + 4);
+    __m128 a2 = _mm_load_ps(a.m + 8);
+    __m128 a3 = _mm_load_ps(a.m + 12);
+    for (uint32_t column = 0; column < 4; column++)
+    {
+        const float *bColumn = b.m + column * 4;
+        __m128 result = _mm_mul_ps(a0, _mm_set1_ps(bColumn[0]));
+        result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(bColumn[1])));
+        result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(bColumn[2])));
+        result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(bColumn[3])));
+        _mm_store_ps(out.m + column * 4, result);
+    }
+#endif
+}
+
+static void transformBounds(SceneStore &scene, uint32_t slot)
+{
+    const float *m = scene.worldMatrices[slot].m;
+    __m128 center = _mm_load_ps(m + 12);
+    center = _mm_add_ps(center, _mm_mul_ps(_mm_load_ps(m + 0), _mm_set1_ps(scene.boundsX[slot])));
+    center = _mm_add_ps(center, _mm_mul_ps(_mm_load_ps(m + 4), _mm_set1_ps(scene.boundsY[slot])));
+    center = _mm_add_ps(center, _mm_mul_ps(_mm_load_ps(m + 8), _mm_set1_ps(scene.boundsZ[slot])));
+    float centerValues[4];
+    _mm_storeu_ps(centerValues, center);
+    scene.worldBoundsX[slot] = centerValues[0];
+    scene.worldBoundsY[slot] = centerValues[1];
+    scene.worldBoundsZ[slot] = centerValues[2];
+
+    //The sphere has to stay a sphere, so the largest axis scale counts
+    float scaleX = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+    float scaleY = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+    float scaleZ = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+    scene.worldBoundsRadius[slot] = scene.boundsRadius[slot] * sqrtf(std::max(scaleX, std::max(scaleY, scaleZ)));
+}
+
+static void updatePartition(SceneStore &scene, const ScenePartition &partition)
+{
+    //Local matrices of the dirty nodes, whole batches are skipped when none of them is dirty
+    uint32_t slot = partition.begin;
+    for (; slot + 4 <= partition.end; slot += 4)
+    {
+        uint32_t batchDirty;
+        memcpy(&batchDirty, &scene.dirty[slot], sizeof(batchDirty));
+        if (batchDirty != 0)
+            composeMatrices4(scene, slot);
+    }
+    for (; slot < partition.end; slot++)
+    {
+        if (!scene.dirty[slot])
+            continue;
+        Transform local;
+        local.position[0] = scene.positionX[slot];
+        local.position[1] = scene.positionY[slot];
+        local.position[2] = scene.positionZ[slot];
+        local.rotation[0] = scene.rotationX[slot];
+        local.rotation[1] = scene.rotationY[slot];
+        local.rotation[2] = scene.rotationZ[slot];
+        local.rotation[3] = scene.rotationW[slot];
+        local.scale[0] = scene.scaleX[slot];
+        local.scale[1] = scene.scaleY[slot];
+        local.scale[2] = scene.scaleZ[slot];
+        composeMatrix(local, scene.localMatrices[slot]);
+    }
+
+    //Parents come first, so a parent that changed in this update is already done
+    const uint32_t version = scene.version;
+    for (slot = partition.begin; slot < partition.end; slot++)
+    {
+        uint32_t parent = scene.parents[slot];
+        bool parentChanged = parent != SCENE_NO_PARENT && scene.changedVersions[parent] == version;
+        if (!scene.dirty[slot] && !parentChanged)
+            continue;
+
+        if (parent == SCENE_NO_PARENT)
+            scene.worldMatrices[slot] = scene.localMatrices[slot];
+        else
+            multiplyMatrices(scene.worldMatrices[parent], scene.localMatrices[slot], scene.worldMatrices[slot]);
+        transformBounds(scene, slot);
+        scene.changedVersions[slot] = version;
+        scene.dirty[slot] = 0;
+    }
+}
+
+void sceneUpdate(SceneStore &scene, uint32_t amountOfWorkers)
+{
+    if (!scene.sorted)
+        sortScene(scene);
+    scene.version++;
+
+    updatePartition(scene, {0, scene.sharedEnd});
+    if (amountOfWorkers <= 1 || scene.partitions.size() <= 1)
+    {
+        for (auto &&partition : scene.partitions)
+        {
+            updatePartition(scene, partition);
+        }
+        return;
+    }
+
+    TaskGraph update;
+    for (auto &&partition : scene.partitions)
+    {
+        taskGraphAdd(update, "scenePartition", [&scene, &partition]() { updatePartition(scene, partition); });
+    }
+    //The calling thread works as well
+    uint32_t threads = std::min(amountOfWorkers, uint32_t(scene.partitions.size()));
+    if (!scene.workerPool || scene.workerPool->threads.size() != threads - 1)
+        scene.workerPool.reset(new WorkerPool(threads - 1));
+    runTaskGraph(update, *scene.workerPool);
+}
+
+uint32_t sceneUploadWorldMatrices(const SceneStore &scene, Matrix4 *destination, uint32_t &bufferVersion)
+{
+    uint32_t amountWritten = 0;
+    const uint32_t count = sceneGetNodeCount(scene);
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        if (scene.changedVersions[slot] > bufferVersion)
+        {
+            destination[slot] = scene.worldMatrices[slot];
+            amountWritten++;
+        }
+    }
+    bufferVersion = scene.version;
+    return amountWritten;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "taskGraph.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+const uint32_t SCENE_NO_PARENT = 0xFFFFFFFFu;
+
+//Column major, the layout GLSL expects for a mat4
+struct alignas(16) Matrix4
+{
+    float m[16];
+};
+
+struct Transform
+{
+    float position[3] = {0.f, 0.f, 0.f};
+    float rotation[4] = {0.f, 0.f, 0.f, 1.f}; //Quaternion xyzw
+    float scale[3] = {1.f, 1.f, 1.f};
+};
+
+//Part of the scene which is updated by one thread. Holds whole subtrees, their ancestors outside of the
+//partition are shared and updated before, so it never waits for another partition
+struct ScenePartition
+{
+    uint32_t begin;
+    uint32_t end;
+};
+
+//Every array is indexed by slot. Slots are sorted by partition and by depth inside a partition, so a parent
+//always comes before its children. The shared ancestors of the partitions come before all partitions. Nodes are
+//referenced from outside by their id, which stays the same when the slots are sorted again
+struct SceneStore
+{
+    std::vector<uint32_t> parents; //Slot of the parent or SCENE_NO_PARENT
+
+    //Local transforms, one array per component so they can be loaded four nodes at a time
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    //Local bounding spheres
+    std::vector<float> boundsX, boundsY, boundsZ, boundsRadius;
+
+    std::vector<Matrix4> localMatrices;
+    std::vector<Matrix4> worldMatrices;
+    std::vector<float> worldBoundsX, worldBoundsY, worldBoundsZ, worldBoundsRadius;
+
+    std::vector<uint8_t> dirty;              //Local transform changed since the last update
+    std::vector<uint32_t> changedVersions;   //Update in which the world matrix changed the last time
+    uint32_t version = 0;                    //Number of the last update
+
+    std::vector<uint32_t> slots;   //Slot of every id
+    std::vector<uint32_t> nodeIds; //Id of every slot
+    std::vector<ScenePartition> partitions;
+    uint32_t sharedEnd = 0; //Slots before it are ancestors of more than one partition
+    bool sorted = true;
+
+    std::unique_ptr<WorkerPool> workerPool; //Created by the first parallel update, kept by sceneClear
+};
+
+//The parent has to exist already. Returns the id of the new node
+uint32_t sceneAddNode(SceneStore &scene, uint32_t parentId, const Transform &local, const float bounds[4]);
+void sceneClear(SceneStore &scene);
+
+void sceneSetLocalTransform(SceneStore &scene, uint32_t id, const Transform &local);
+
+inline uint32_t sceneGetSlot(const SceneStore &scene, uint32_t id)
+{
+    return scene.slots[id];
+}
+
+inline uint32_t sceneGetNodeCount(const SceneStore &scene)
+{
+    return scene.parents.size();
+}
+
+//Recomputes the world matrices and bounds of the dirty nodes and of everything below them. The shared
+//ancestors are updated on the calling thread, then the partitions are spread over amountOfWorkers threads of
+//the worker pool of the scene. With 1 everything runs on the calling thread
+void sceneUpdate(SceneStore &scene, uint32_t amountOfWorkers);
+
+//Writes the world matrices which changed since bufferVersion to destination[slot] and moves bufferVersion to
+//the current version. Every per frame buffer keeps its own version. Returns the amount of matrices written
+uint32_t sceneUploadWorldMatrices(const SceneStore &scene, Matrix4 *destination, uint32_t &bufferVersion);
+
+//Scalar version of the batched local matrix build, used for nodes that do not fill a whole batch
+void composeMatrix(const Transform &transform, Matrix4 &out);
+//out = a * b, SSE or AVX when the compiler may use it
+void multiplyMatrices(const Matrix4 &a, const Matrix4 &b, Matrix4 &out);
@@ -7,19 +7,33 @@ out gl_PerVertex {
 
 layout(location = 0) out vec3 fragColor;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
-
-vec3 colors[3] = vec3[](
-    vec3(1, 0, 0),
-    vec3(0, 1, 0),
-    vec3(0, 0, 1) 
-);
+//World matrix of the scene node, one per instance
+layout(location = 0) in mat4 model;
+
+//QuantizedVertex (see mesh.h), already turned into floats by the vertex input formats
+layout(location = 4) in vec4 quantizedPosition;
+layout(location = 5) in vec2 octahedralNormal;
+layout(location = 6) in vec2 uv;
+
+//Maps the quantized positions from -1..1 back into the mesh
+layout(push_constant) uniform PushConstants {
+    vec4 positionScale;
+    vec4 positionOffset;
+} pushConstants;
+
+vec3 decodeOctahedral(vec2 encoded){
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
 
 void main(){
-    fragColor = colors[gl_VertexIndex];
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-}
\ No newline at end of file
+    vec3 normal = decodeOctahedral(octahedralNormal);
+    float light = 0.5 + 0.5 * max(dot(normal, vec3(0.0, 0.0, -1.0)), 0.0);
+    fragColor = clamp(vec3(1.0 - uv.x - uv.y, uv.x, uv.y), 0.0, 1.0) * light;
+
+    vec3 position = quantizedPosition.xyz * pushConstants.positionScale.xyz + pushConstants.positionOffset.xyz;
+    gl_Position = model * vec4(position, 1.0);
+}
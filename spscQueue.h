@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+//Lock-free ring buffer for exactly one producer thread and one consumer thread.
+//Capacity has to be a power of two, one slot stays empty to tell full from empty
+template <typename T, size_t Capacity>
+struct SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+    T slots[Capacity];
+    alignas(64) std::atomic<size_t> head{0}; //Next slot to read, only written by the consumer
+    alignas(64) std::atomic<size_t> tail{0}; //Next slot to write, only written by the producer
+};
+
+//Producer side, returns false if the queue is full
+template <typename T, size_t Capacity>
+bool spscQueuePush(SpscQueue<T, Capacity> &queue, const T &value)
+{
+    size_t tail = queue.tail.load(std::memory_order_relaxed);
+    size_t next = (tail + 1) & (Capacity - 1);
+    if (next == queue.head.load(std::memory_order_acquire))
+        return false;
+
+    queue.slots[tail] = value;
+    queue.tail.store(next, std::memory_order_release);
+    return true;
+}
+
+//Consumer side, returns false if the queue is empty
+template <typename T, size_t Capacity>
+bool spscQueuePop(SpscQueue<T, Capacity> &queue, T &value)
+{
+    size_t head = queue.head.load(std::memory_order_relaxed);
+    if (head == queue.tail.load(std::memory_order_acquire))
+        return false;
+
+    value = queue.slots[head];
+    queue.head.store((head + 1) & (Capacity - 1), std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,212 @@
+#include "taskGraph.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <ostream>
+
+uint32_t taskGraphAdd(TaskGraph &graph, const char *name, std::function<void()> run,
+                      const std::vector<uint32_t> &dependencies, bool mainThread)
+{
+    Task task;
+    task.name = name;
+    task.run = run;
+    task.dependencies = dependencies;
+    task.mainThread = mainThread;
+    graph.tasks.push_back(task);
+    return graph.tasks.size() - 1;
+}
+
+struct TaskGraphRun
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<uint32_t> ready;           //Tasks any thread may run
+    std::deque<uint32_t> readyMainThread; //Tasks only the calling thread may run
+    std::vector<uint32_t> remainingDependencies;
+    std::vector<std::vector<uint32_t>> dependents;
+    size_t finished = 0;
+    std::exception_ptr failure; //First exception thrown by a task, no new tasks start once it is set
+    std::chrono::steady_clock::time_point start;
+};
+
+static void makeReady(TaskGraph &graph, TaskGraphRun &run, uint32_t task)
+{
+    if (graph.tasks[task].mainThread)
+        run.readyMainThread.push_back(task);
+    else
+        run.ready.push_back(task);
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//Takes ready tasks until the whole graph is done or a task failed
+static void runTasks(TaskGraph &graph, TaskGraphRun &run, bool isMainThread)
+{
+    std::unique_lock<std::mutex> lock(run.mutex);
+    while (run.finished < graph.tasks.size() && !run.failure)
+    {
+        uint32_t task;
+        if (isMainThread && !run.readyMainThread.empty())
+        {
+            task = run.readyMainThread.front();
+            run.readyMainThread.pop_front();
+        }
+        else if (!run.ready.empty())
+        {
+            task = run.ready.front();
+            run.ready.pop_front();
+        }
+        else
+        {
+            run.changed.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        graph.tasks[task].startMs = millisecondsSince(run.start);
+        std::exception_ptr failure;
+        try
+        {
+            graph.tasks[task].run();
+        }
+        catch (...)
+        {
+            failure = std::current_exception();
+        }
+        graph.tasks[task].endMs = millisecondsSince(run.start);
+        lock.lock();
+
+        if (failure)
+        {
+            if (!run.failure)
+                run.failure = failure;
+            run.changed.notify_all();
+            continue;
+        }
+
+        run.finished++;
+        for (uint32_t dependent : run.dependents[task])
+        {
+            if (--run.remainingDependencies[dependent] == 0)
+                makeReady(graph, run, dependent);
+        }
+        run.changed.notify_all();
+    }
+}
+
+static void prepareRun(TaskGraph &graph, TaskGraphRun &run)
+{
+    run.start = std::chrono::steady_clock::now();
+    run.remainingDependencies.resize(graph.tasks.size());
+    run.dependents.resize(graph.tasks.size());
+    for (uint32_t t = 0; t < graph.tasks.size(); t++)
+    {
+        run.remainingDependencies[t] = graph.tasks[t].dependencies.size();
+        for (uint32_t dependency : graph.tasks[t].dependencies)
+        {
+            run.dependents[dependency].push_back(t);
+        }
+        if (run.remainingDependencies[t] == 0)
+            makeReady(graph, run, t);
+    }
+}
+
+void runTaskGraph(TaskGraph &graph, uint32_t amountOfWorkers)
+{
+    TaskGraphRun run;
+    prepareRun(graph, run);
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < amountOfWorkers; i++)
+    {
+        workers.emplace_back(runTasks, std::ref(graph), std::ref(run), false);
+    }
+    runTasks(graph, run, true);
+    for (auto &&worker : workers)
+    {
+        worker.join();
+    }
+    if (run.failure)
+        std::rethrow_exception(run.failure);
+}
+
+static void runWorker(WorkerPool &pool)
+{
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    while (true)
+    {
+        pool.changed.wait(lock, [&pool]() { return pool.stopping || pool.openSlots > 0; });
+        if (pool.stopping)
+            return;
+        pool.openSlots--;
+        pool.busy++;
+        const std::function<void()> *job = pool.job;
+        lock.unlock();
+        (*job)();
+        lock.lock();
+        if (--pool.busy == 0)
+            pool.changed.notify_all();
+    }
+}
+
+WorkerPool::WorkerPool(uint32_t amountOfWorkers)
+{
+    for (uint32_t i = 0; i < amountOfWorkers; i++)
+    {
+        threads.emplace_back(runWorker, std::ref(*this));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    for (auto &&thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void runTaskGraph(TaskGraph &graph, WorkerPool &pool)
+{
+    TaskGraphRun run;
+    prepareRun(graph, run);
+
+    //The calling thread takes one task, so more workers than the other tasks would only wake up for nothing
+    std::function<void()> job = [&graph, &run]() { runTasks(graph, run, false); };
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.job = &job;
+        pool.openSlots = std::min<size_t>(pool.threads.size(), std::max<size_t>(graph.tasks.size(), 1) - 1);
+    }
+    pool.changed.notify_all();
+    runTasks(graph, run, true);
+
+    //Workers that did not join yet must not, the ones inside still touch run
+    {
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        pool.openSlots = 0;
+        pool.changed.wait(lock, [&pool]() { return pool.busy == 0; });
+        pool.job = NULL;
+    }
+    if (run.failure)
+        std::rethrow_exception(run.failure);
+}
+
+void printTaskGraphTimeline(const TaskGraph &graph, std::ostream &out)
+{
+    out << std::fixed << std::setprecision(2);
+    for (auto &&task : graph.tasks)
+    {
+        out << std::left << std::setw(16) << task.name << std::right
+            << std::setw(9) << task.startMs << " ms -> " << std::setw(9) << task.endMs << " ms\n";
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//A unit of work that may start once all of its dependencies have finished
+struct Task
+{
+    std::string name;
+    std::function<void()> run;
+    std::vector<uint32_t> dependencies;
+    bool mainThread = false; //E.g. window creation, which GLFW only allows on the main thread
+
+    //Filled in by runTaskGraph, milliseconds since the start of the run
+    double startMs = 0.0;
+    double endMs = 0.0;
+};
+
+struct TaskGraph
+{
+    std::vector<Task> tasks;
+};
+
+//Dependencies have to be added before the tasks that depend on them
+uint32_t taskGraphAdd(TaskGraph &graph, const char *name, std::function<void()> run,
+                      const std::vector<uint32_t> &dependencies = {}, bool mainThread = false);
+
+//Runs every task once, in parallel where the dependencies allow it. The calling thread takes part
+//and runs the main thread tasks. Returns when all tasks are done. If a task throws, no further tasks start,
+//the running ones finish and the first exception is rethrown here
+void runTaskGraph(TaskGraph &graph, uint32_t amountOfWorkers);
+
+//Threads that stay alive between task graph runs, for graphs that run every frame. The threads sleep while
+//no graph runs and are joined when the pool is destroyed. Only one graph may run on a pool at a time
+struct WorkerPool
+{
+    explicit WorkerPool(uint32_t amountOfWorkers);
+    ~WorkerPool();
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable changed;
+    const std::function<void()> *job = NULL; //Work of the running graph
+    uint32_t openSlots = 0;                  //Workers that may still join the running graph
+    uint32_t busy = 0;                       //Workers inside the running graph
+    bool stopping = false;
+};
+
+//Same as above, with the threads of the pool as the workers
+void runTaskGraph(TaskGraph &graph, WorkerPool &pool);
+
+//Start and end of every task, for the diagnostics log
+void printTaskGraphTimeline(const TaskGraph &graph, std::ostream &out);
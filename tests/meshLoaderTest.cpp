@@ -0,0 +1,106 @@
+//Malformed meshes have to throw on the caller no matter how many workers parse them
+#include "../meshLoader.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &name)
+{
+    std::cout << (condition ? "passed " : "FAILED ") << name << std::endl;
+    if (!condition)
+        failures++;
+}
+
+template <typename Parse>
+static bool throwsRuntimeError(Parse parse)
+{
+    try
+    {
+        parse();
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+//Several MB of valid triangles with one face without position indices in the middle, so it lands in a chunk of
+//its own when parsed by more than one worker
+static std::string createMalformedObj()
+{
+    std::string obj;
+    std::string triangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf -3 -2 -1\n";
+    while (obj.size() < (3 << 20))
+        obj += triangle;
+    obj += "f /1 /2 /3\n";
+    while (obj.size() < (6 << 20))
+        obj += triangle;
+    return obj;
+}
+
+static void appendChunk(std::string &glb, uint32_t type, std::string data, char padding)
+{
+    while (data.size() % 4 != 0)
+        data += padding;
+    uint32_t header[2] = {uint32_t(data.size()), type};
+    glb.append(reinterpret_cast<const char *>(header), sizeof(header));
+    glb += data;
+}
+
+//Two primitives sharing three positions, the second one indexes a fourth vertex that does not exist
+static std::string createMalformedGlb()
+{
+    std::string json =
+        "{\"asset\":{\"version\":\"2.0\"},"
+        "\"buffers\":[{\"byteLength\":48}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":36},{\"buffer\":0,\"byteOffset\":36,\"byteLength\":12}],"
+        "\"accessors\":["
+        "{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"},"
+        "{\"bufferView\":1,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"},"
+        "{\"bufferView\":1,\"byteOffset\":6,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}],"
+        "\"meshes\":[{\"primitives\":["
+        "{\"attributes\":{\"POSITION\":0},\"indices\":1},"
+        "{\"attributes\":{\"POSITION\":0},\"indices\":2}]}]}";
+
+    std::string bin(48, '\0');
+    float positions[9] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+    uint16_t indices[6] = {0, 1, 2, 0, 2, 3};
+    memcpy(&bin[0], positions, sizeof(positions));
+    memcpy(&bin[36], indices, sizeof(indices));
+
+    std::string chunks;
+    appendChunk(chunks, 0x4E4F534A, json, ' ');
+    appendChunk(chunks, 0x004E4942, bin, '\0');
+    uint32_t header[3] = {0x46546C67, 2, uint32_t(12 + chunks.size())};
+    std::string glb(reinterpret_cast<const char *>(header), sizeof(header));
+    return glb + chunks;
+}
+
+int main()
+{
+    std::string obj = createMalformedObj();
+    for (uint32_t workers : {1u, 4u})
+    {
+        check(throwsRuntimeError([&]() {
+            MeshData mesh;
+            parseObj(obj.data(), obj.size(), mesh, workers);
+        }), "malformed OBJ face throws with " + std::to_string(workers) + " workers");
+    }
+
+    std::string glb = createMalformedGlb();
+    for (uint32_t workers : {1u, 4u})
+    {
+        check(throwsRuntimeError([&]() {
+            MeshData mesh;
+            parseGlb(glb.data(), glb.size(), mesh, workers);
+        }), "malformed glTF index throws with " + std::to_string(workers) + " workers");
+    }
+
+    return failures == 0 ? 0 : 1;
+}
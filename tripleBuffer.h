@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+//Hands the newest value from one writer thread to one reader thread without locks or waiting.
+//The writer fills the back buffer and publishes it, the reader always gets the newest published value
+//and may skip older ones. Both sides own one buffer at a time, the third one is in the middle
+template <typename T>
+struct TripleBuffer
+{
+    static const uint32_t INDEX_MASK = 3;
+    static const uint32_t NEW_BIT = 4; //Set when the middle buffer was published after the last read
+
+    T buffers[3] = {};
+    alignas(64) std::atomic<uint32_t> middle{1};
+    alignas(64) uint32_t back = 0;  //Writer thread only
+    alignas(64) uint32_t front = 2; //Reader thread only
+};
+
+//Writer side, the buffer to fill before the next publish. It still holds the value of three publishes ago
+template <typename T>
+T &tripleBufferBack(TripleBuffer<T> &buffer)
+{
+    return buffer.buffers[buffer.back];
+}
+
+template <typename T>
+void tripleBufferPublish(TripleBuffer<T> &buffer)
+{
+    uint32_t previous = buffer.middle.exchange(buffer.back | TripleBuffer<T>::NEW_BIT, std::memory_order_acq_rel);
+    buffer.back = previous & TripleBuffer<T>::INDEX_MASK;
+}
+
+//Reader side, the reference stays valid until the next call
+template <typename T>
+const T &tripleBufferRead(TripleBuffer<T> &buffer)
+{
+    if (buffer.middle.load(std::memory_order_relaxed) & TripleBuffer<T>::NEW_BIT)
+    {
+        uint32_t previous = buffer.middle.exchange(buffer.front, std::memory_order_acq_rel);
+        buffer.front = previous & TripleBuffer<T>::INDEX_MASK;
+    }
+    return buffer.buffers[buffer.front];
+}
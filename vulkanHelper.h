@@ -0,0 +1,24 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <iostream>
+
+#define ASSERT_VULKAN(val)                                         \
+    if (val != VK_SUCCESS)                                         \
+    {                                                              \
+        std::cout << "---------------------------------------\n";  \
+        std::cout << "ERROR: 'RESULT != VK_SUCCESS'" << std::endl; \
+        std::cout << __FILE__ << ": " << __LINE__ << std::endl;    \
+        std::cout << val << std::endl;                             \
+        std::cout << "---------------------------------------\n";  \
+    }
+
+//Index of the first memory type allowed by typeBits that has all of the property flags, -1 if there is none
+inline int findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties &memoryProperties, uint32_t typeBits, VkMemoryPropertyFlags flags)
+{
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+            return i;
+    }
+    return -1;
+}